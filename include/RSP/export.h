@@ -0,0 +1,62 @@
+/** ********************************************************************************
+ * @section Export_Overview Overview
+ * @file export.h
+ * @brief Header file for the RSP symbol export macro.
+ * @details
+ * Typical use cases:
+ * - Marking the public API when RSP is built or consumed as a shared library.
+ * *********************************************************************************
+ * @section RSP_Export Export Module
+ * <RSP/export.h>
+ ***********************************************************************************
+ * @section RSP_Metadata Metadata
+ * @author Estorc
+ * @version v1.0
+ * @copyright Copyright (c) 2025 Estorc MIT License.
+ **********************************************************************************/
+/*                             This file is part of
+ *                                      RSP
+ *                        (https://github.com/Estorc/RSP)
+ ***********************************************************************************
+ * Copyright (c) 2025 Estorc.
+ * This file is licensed under the MIT License.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ***********************************************************************************/
+
+#pragma once
+
+/**
+ * @brief Marks a function of the public API.
+ * The shared library is compiled with hidden visibility, so only functions marked with RSP_API
+ * are exported. RSP_SHARED is defined for the users of the shared library and RSP_BUILDING_SHARED
+ * while building it; with neither defined (static library) the macro expands to nothing.
+ */
+#if defined(RSP_SHARED) || defined(RSP_BUILDING_SHARED)
+    #if defined(_WIN32)
+        #if defined(RSP_BUILDING_SHARED)
+            #define RSP_API __declspec(dllexport)
+        #else
+            #define RSP_API __declspec(dllimport)
+        #endif
+    #elif defined(__GNUC__)
+        #define RSP_API __attribute__((visibility("default")))
+    #else
+        #define RSP_API
+    #endif
+#else
+    #define RSP_API
+#endif
@@ -0,0 +1,185 @@
+/** ********************************************************************************
+ * @section Lexer_Overview Overview
+ * @file lexer.h
+ * @brief Header file for the RSP incremental lexer.
+ * @details
+ * Typical use cases:
+ * - Splitting a text into tokens with an ordered list of RSP rules.
+ * - Keeping the tokens of an edited document up to date without re-lexing it whole.
+ * *********************************************************************************
+ * @section RSP_Lexer Lexer Module
+ * <RSP/lexer.h>
+ ***********************************************************************************
+ * @section RSP_Metadata Metadata
+ * @author Estorc
+ * @version v1.0
+ * @copyright Copyright (c) 2025 Estorc MIT License.
+ **********************************************************************************/
+/*                             This file is part of
+ *                                      RSP
+ *                        (https://github.com/Estorc/RSP)
+ ***********************************************************************************
+ * Copyright (c) 2025 Estorc.
+ * This file is licensed under the MIT License.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ***********************************************************************************/
+
+#pragma once
+#include <RSP/rsp.h>
+#include <stddef.h>
+
+/**
+ * @brief Rule index of the tokens covering a byte that no rule matches.
+ */
+#define RSP_LEX_NO_RULE ((size_t)-1)
+
+/**
+ * @brief Structure representing a lexer rule.
+ * @note This structure is used internally by the RSP lexer module.
+ */
+struct rsp_lex_rule {
+    char * source;                      // Copy of the pattern string, NULL for static rules
+    struct rsp_pattern * compiled;      // Pattern owned by the lexer, NULL for static rules
+    const struct rsp_pattern * pattern; // Pattern matched by the rule
+};
+
+/**
+ * @brief Structure representing a lexer, an ordered list of rules.
+ * At each position the first rule producing a non-empty match wins.
+ */
+struct rsp_lexer {
+    struct rsp_lex_rule * rules;
+    size_t rule_count;
+};
+
+/**
+ * @brief Structure representing a token produced by the lexer.
+ */
+struct rsp_lex_token {
+    size_t rule;                        // Index of the matching rule, or RSP_LEX_NO_RULE
+    size_t offset;                      // Offset of the token in the text
+    size_t length;                      // Length of the token in bytes
+    size_t lookahead;                   // Bytes past the token inspected by the rules while lexing it
+};
+
+/**
+ * @brief Number of buckets of the lookahead histogram of a document, one per power of two.
+ */
+#define RSP_LEX_LOOKAHEAD_BUCKETS (sizeof(size_t) * 8 + 1)
+
+/**
+ * @brief Structure representing a lexed document.
+ * The document owns a copy of its text and the token stream covering it.
+ * The text is read with rsp_lex_document_text() and the tokens with rsp_lex_document_token().
+ * @note The text and the tokens are kept in gap buffers whose gaps sit near the last edit. Tokens
+ * after the gap store their distance from the end of the text, so changing the text length shifts
+ * them for free.
+ */
+struct rsp_lex_document {
+    const struct rsp_lexer * lexer;
+    char * text;                        // Gap buffer of the text, NUL terminated after the gap
+    size_t length;
+    size_t text_capacity;
+    size_t text_gap_start;              // Offset of the gap in the text
+    size_t text_gap_length;
+    size_t token_count;
+    struct rsp_lex_token * tokens;      // Gap buffer of token_count tokens
+    size_t token_capacity;
+    size_t token_gap_start;             // Index of the gap, the number of tokens stored before it
+    size_t token_gap_length;
+    size_t lookahead_counts[RSP_LEX_LOOKAHEAD_BUCKETS]; // Number of tokens per lookahead bit length
+    size_t edit_moved;                  // Tokens and bytes the gap buffers moved during the last edit
+};
+
+/**
+ * @brief Creates an empty lexer.
+ * @return A pointer to the lexer.
+ * @note The returned lexer should be freed using rsp_lexer_free() when no longer needed.
+ */
+RSP_API struct rsp_lexer * rsp_lexer_create(void);
+
+/**
+ * @brief Frees a lexer and the patterns of its rules.
+ * @param lexer The lexer to be freed.
+ */
+RSP_API void rsp_lexer_free(struct rsp_lexer * lexer);
+
+/**
+ * @brief Appends a rule to a lexer.
+ * @param lexer The lexer to add the rule to.
+ * @param pattern The pattern string of the rule, copied by the lexer.
+ * @param flags A combination of rsp_compile_flags values.
+ * @return The index of the rule, reported in the rule field of its tokens.
+ * @note Rules must not be added while documents are using the lexer.
+ */
+RSP_API size_t rsp_lexer_add_rule(struct rsp_lexer * lexer, const char * pattern, unsigned int flags);
+
+/**
+ * @brief Appends a rule matching an already built pattern, such as one from <RSP/static.h>.
+ * @param lexer The lexer to add the rule to.
+ * @param pattern The pattern of the rule, which must outlive the lexer and is not freed by it.
+ * @return The index of the rule, reported in the rule field of its tokens.
+ * @note Rules must not be added while documents are using the lexer.
+ */
+RSP_API size_t rsp_lexer_add_static_rule(struct rsp_lexer * lexer, const struct rsp_pattern * pattern);
+
+/**
+ * @brief Creates a document and lexes its whole text.
+ * @param lexer The lexer used for this document, which must outlive it.
+ * @param text The initial text of the document, copied by the document.
+ * @return A pointer to the document.
+ * @note The returned document should be freed using rsp_lex_document_free() when no longer needed.
+ */
+RSP_API struct rsp_lex_document * rsp_lex_document_create(const struct rsp_lexer * lexer, const char * text);
+
+/**
+ * @brief Frees a document, its text and its tokens.
+ * @param document The document to be freed.
+ */
+RSP_API void rsp_lex_document_free(struct rsp_lex_document * document);
+
+/**
+ * @brief Returns the text of a document.
+ * @param document The document to read the text of.
+ * @return The NUL terminated text, valid until the next edit of the document.
+ * @note Closing the gap of the text costs the distance from the last edit to the end of the text.
+ */
+RSP_API const char * rsp_lex_document_text(struct rsp_lex_document * document);
+
+/**
+ * @brief Returns a token of a document.
+ * @param document The document to read the token from.
+ * @param index The index of the token, less than the token_count of the document.
+ * @return A copy of the token, with its offset in the current text.
+ */
+RSP_API struct rsp_lex_token rsp_lex_document_token(const struct rsp_lex_document * document, size_t index);
+
+/**
+ * @brief Applies an edit to a document and re-lexes the affected tokens.
+ * @param document The document to be edited.
+ * @param offset The offset of the edit in the current text.
+ * @param removed_length The number of bytes removed at offset.
+ * @param inserted_text The text inserted at offset.
+ * @return The number of tokens lexed again.
+ * @note The tokens and bytes moved by the gap buffers are left in the edit_moved field of the document.
+ * @details
+ * Lexing restarts at the first token whose inspected bytes reach the edit, and stops as soon
+ * as a new token ends where an old token following the edit starts. The remaining tokens are
+ * kept and shifted lazily, so the cost depends on the size of the edit, the lookahead of the
+ * rules and the distance from the previous edit, rather than on the size of the document.
+ */
+RSP_API size_t rsp_lex_document_edit(struct rsp_lex_document * document, size_t offset, size_t removed_length, const char * inserted_text);
@@ -39,7 +39,9 @@
  ***********************************************************************************/
 
 #pragma once
+#include <RSP/export.h>
 #include <RSP/string.h>
+#include <stdbool.h>
 
 /**
  * @brief Enumeration of token types used in pattern matching.
@@ -54,7 +56,7 @@ enum rsp_token_type {
     RSP_TT_ONE_ZERO,            // ?
     RSP_TT_POSITIVE_LOOKAHEAD,  // !
     RSP_TT_NEGATIVE_LOOKAHEAD,  // ~
-    RSP_TT_CHAR_CLASS,          // $a, $d, $w, etc.
+    RSP_TT_CHAR_CLASS,          // $a, $d, $w, $_, $s, $x, $p or a registered class
     RSP_TT_ESCAPE,              // \x
     RSP_TT_RANGE,               // [a-z]
     RSP_TT_NEG_RANGE,           // [^...]
@@ -73,20 +75,35 @@ struct rsp_token {
     void * data;
 };
 
+/**
+ * @brief Flags controlling how a pattern is compiled and matched.
+ * Flags are combined with a bitwise OR and passed to rsp_compile_with_flags().
+ */
+enum rsp_compile_flags {
+    RSP_CF_NONE = 0,            // Byte oriented matching (default)
+    RSP_CF_UTF8 = 1 << 0,       // Codepoint oriented matching of UTF-8 input
+    RSP_CF_REVERSE = 1 << 1     // Also build the reversed program used by rsp_match_reverse() and rsp_rsearch()
+};
+
 /**
  * @brief Structure representing a compiled pattern.
- * The pattern consists of an array of tokens.
+ * The pattern consists of an array of tokens, the flags it was compiled with and, for
+ * RSP_CF_REVERSE, the reversed program built from the tokens.
  * @note This structure is used internally by the RSP string module.
  */
+struct rsp_reverse_program;
+
 struct rsp_pattern {
     struct rsp_token * tokens;
+    unsigned int flags;
+    struct rsp_reverse_program * reverse;
 };
 
 /**
  * @brief Prints the compiled pattern for debugging purposes.
  * @param pattern The compiled rsp_pattern to be printed.
  */
-void rsp_print(struct rsp_pattern *pattern);
+RSP_API void rsp_print(const struct rsp_pattern *pattern);
 
 /**
  * @brief Compiles a pattern string into a rsp_pattern structure.
@@ -94,21 +111,86 @@ void rsp_print(struct rsp_pattern *pattern);
  * @return A pointer to the compiled rsp_pattern.
  * @note The returned rsp_pattern should be freed using rsp_free() when no longer needed.
  */
-struct rsp_pattern * rsp_compile(const char * pattern_ptr);
+RSP_API struct rsp_pattern * rsp_compile(const char * pattern_ptr);
+
+/**
+ * @brief Compiles a pattern string into a rsp_pattern structure using the given flags.
+ * @param pattern_ptr The pattern string to be compiled.
+ * @param flags A combination of rsp_compile_flags values.
+ * @return A pointer to the compiled rsp_pattern, or NULL if RSP_CF_REVERSE is given and the
+ * pattern repeats an operator, as in "a**", which has no reversed program.
+ * @note With RSP_CF_UTF8, literals, '.' and ranges operate on whole codepoints, and $a / $w
+ * also accept Unicode letters (and decimal digits for $w). Invalid UTF-8 bytes are matched
+ * one at a time by '.' and negated ranges only.
+ * @note The returned rsp_pattern should be freed using rsp_free() when no longer needed.
+ */
+RSP_API struct rsp_pattern * rsp_compile_with_flags(const char * pattern_ptr, unsigned int flags);
 
 /**
  * @brief Frees the memory allocated for a compiled rsp_pattern.
  * @param pattern The rsp_pattern to be freed.
  */
-void rsp_free(struct rsp_pattern * pattern);
+RSP_API void rsp_free(struct rsp_pattern * pattern);
+
+/**
+ * @brief Registers a custom character class usable as $name in patterns.
+ * @param name The class name, which must not be one of the built-in classes
+ * ($a letters, $d digits, $w word, $_ underscore, $s whitespace, $x hex digits, $p punctuation).
+ * @param members The bytes belonging to the class, where "x-y" denotes an inclusive byte range.
+ * @return true on success, false if the name is reserved or all class slots are taken.
+ * @note Registering an existing custom class replaces its members. Up to 26 custom classes can exist.
+ * @note Classes are process wide and read while matching, so register them before matching from several threads.
+ * @note In UTF-8 mode a custom class only matches single bytes below 0x80.
+ */
+RSP_API bool rsp_register_class(char name, const char * members);
 
 /**
  * @brief Matches a string against a compiled pattern.
  * @param str The string to be matched.
  * @param pattern The compiled rsp_pattern to match against.
- * @return A pointer to the position in the string after the match, or NULL if no match is found.
+ * @return A pointer to the position in the string after the match, or NULL if no match is found
+ * or the pattern is reversed, see rsp_match_reverse() and rsp_rsearch().
+ */
+RSP_API const char * rsp_match(const char * str, const struct rsp_pattern * pattern);
+
+/**
+ * @brief Matches a string against a compiled pattern and reports how far the input was read.
+ * @param str The string to be matched.
+ * @param pattern The compiled rsp_pattern to match against.
+ * @param reach Receives one past the last byte inspected, including lookaheads and failed attempts.
+ * @return A pointer to the position in the string after the match, or NULL if no match is found
+ * or the pattern is reversed, in which case *reach is str.
+ * @note Bytes at or past *reach cannot change the result, which makes cached results reusable after an edit.
+ */
+RSP_API const char * rsp_match_with_reach(const char * str, const struct rsp_pattern * pattern, const char ** reach);
+
+/**
+ * @brief Matches the end of a buffer against a pattern compiled with RSP_CF_REVERSE.
+ * @param str The start of the buffer, which does not need to be NUL terminated.
+ * @param length The length of the buffer; the match must end at str + length.
+ * @param pattern The reversed rsp_pattern to match against.
+ * @return A pointer to the leftmost start from which rsp_match() would end at str + length,
+ * or NULL if there is none or the pattern is not reversed.
+ * @details
+ * Reverse matching finds the same strings as forward matching, with the end of the buffer as
+ * the end of the input, so "$d+$d~" matches the digits ending a buffer. The reversed program is
+ * followed back from the end once, lookaheads and the stop tests of repetitions still reading the
+ * text after each position, and the start it finds is confirmed by a single forward run.
+ */
+RSP_API const char * rsp_match_reverse(const char * str, size_t length, const struct rsp_pattern * pattern);
+
+/**
+ * @brief Finds the last match of a pattern compiled with RSP_CF_REVERSE in a buffer.
+ * @param str The start of the buffer, which does not need to be NUL terminated.
+ * @param length The length of the buffer.
+ * @param pattern The reversed rsp_pattern to search for.
+ * @param match_end Receives the end of the match when not NULL.
+ * @return A pointer to the start of the match ending the furthest in the buffer, the leftmost one
+ * when several do, or NULL if there is none.
+ * @note Lookaheads see the rest of the buffer past the end of the match.
+ * @note Every match is found by one backward run over the buffer and one forward run from its start.
  */
-const char * rsp_match(const char * str, struct rsp_pattern * pattern);
+RSP_API const char * rsp_rsearch(const char * str, size_t length, const struct rsp_pattern * pattern, const char ** match_end);
 
 /**
  * @brief Compiles a pattern string and matches it against a given string.
@@ -117,4 +199,4 @@ const char * rsp_match(const char * str, struct rsp_pattern * pattern);
  * @return A pointer to the position in the string after the match, or NULL if no match is found.
  * @note This function handles both compilation and matching, and frees the compiled pattern afterwards.
  */
-const char * rsp_compile_and_match(const char * str, const char * pattern);
\ No newline at end of file
+RSP_API const char * rsp_compile_and_match(const char * str, const char * pattern);
\ No newline at end of file
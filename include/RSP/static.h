@@ -0,0 +1,113 @@
+/** ********************************************************************************
+ * @section Static_Overview Overview
+ * @file static.h
+ * @brief Header file for statically allocated RSP patterns.
+ * @details
+ * Typical use cases:
+ * - Declaring a fixed rule set as constant patterns needing no rsp_compile() at startup.
+ * - Expanding an X-macro rule table into constant patterns and a rule array.
+ *
+ * Each macro mirrors a token produced by rsp_compile(), so a static pattern is
+ * written as its compiled form. For example "[$a_][$w_]*[$w_]~" becomes:
+ * @code
+ * static const struct rsp_pattern identifier = RSP_STATIC_PATTERN(
+ *     RSP_STATIC_RANGE(RSP_STATIC_CLASS('a'), RSP_STATIC_CHAR("_")),
+ *     RSP_STATIC_ZERO_PLUS(RSP_STATIC_RANGE(RSP_STATIC_CLASS('w'), RSP_STATIC_CHAR("_"))),
+ *     RSP_STATIC_NEGATIVE_LOOKAHEAD(RSP_STATIC_RANGE(RSP_STATIC_CLASS('w'), RSP_STATIC_CHAR("_")))
+ * );
+ * @endcode
+ * and an X-macro table expands with:
+ * @code
+ * #define RULES(X) \
+ *     X(identifier, RSP_STATIC_RANGE(RSP_STATIC_CLASS('a'), RSP_STATIC_CHAR("_")), ...) \
+ *     X(digit, RSP_STATIC_CLASS('d'))
+ * RULES(RSP_STATIC_DEFINE)
+ * static const struct rsp_pattern * const rules[] = { RULES(RSP_STATIC_REFERENCE) };
+ * @endcode
+ * @note Static patterns must be defined at file scope, where compound literals have static
+ * storage. They are used with rsp_match() and must never be passed to rsp_free().
+ * *********************************************************************************
+ * @section RSP_Static Static Module
+ * <RSP/static.h>
+ ***********************************************************************************
+ * @section RSP_Metadata Metadata
+ * @author Estorc
+ * @version v1.0
+ * @copyright Copyright (c) 2025 Estorc MIT License.
+ **********************************************************************************/
+/*                             This file is part of
+ *                                      RSP
+ *                        (https://github.com/Estorc/RSP)
+ ***********************************************************************************
+ * Copyright (c) 2025 Estorc.
+ * This file is licensed under the MIT License.
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ ***********************************************************************************/
+
+#pragma once
+#include <RSP/rsp.h>
+#include <stddef.h>
+
+/**
+ * @brief Builds a token of the given type and data.
+ */
+#define RSP_STATIC_TOKEN(token_type, token_data) { .type = (token_type), .data = (void *)(token_data) }
+
+/**
+ * @brief Builds a terminated constant token array from a list of tokens.
+ */
+#define RSP_STATIC_TOKENS(...) \
+    ((struct rsp_token *)(const struct rsp_token[]){ __VA_ARGS__, RSP_STATIC_TOKEN(RSP_TT_TERMINATOR, NULL) })
+
+/**
+ * @brief Builds a constant sub-pattern from a list of tokens, as referenced by node tokens.
+ */
+#define RSP_STATIC_SUB_PATTERN(...) \
+    (&(const struct rsp_pattern){ .tokens = RSP_STATIC_TOKENS(__VA_ARGS__), .flags = RSP_CF_NONE })
+
+/**
+ * @brief Initializer of a top-level static pattern compiled with the given rsp_compile_flags.
+ * @note Matching only reads the flags of the top-level pattern.
+ * @note With RSP_CF_REVERSE, the reversed program is built on each call to rsp_match_reverse() or rsp_rsearch().
+ */
+#define RSP_STATIC_PATTERN_WITH_FLAGS(pattern_flags, ...) \
+    { .tokens = RSP_STATIC_TOKENS(__VA_ARGS__), .flags = (pattern_flags), .reverse = NULL }
+
+/**
+ * @brief Initializer of a top-level static pattern.
+ */
+#define RSP_STATIC_PATTERN(...) RSP_STATIC_PATTERN_WITH_FLAGS(RSP_CF_NONE, __VA_ARGS__)
+
+// Leaf tokens
+#define RSP_STATIC_CHAR(literal) RSP_STATIC_TOKEN(RSP_TT_CHAR, literal)             // One character given as a string literal, "x" or "\xC3\xA9"
+#define RSP_STATIC_WILDCARD RSP_STATIC_TOKEN(RSP_TT_WILDCARD, NULL)                 // .
+#define RSP_STATIC_CLASS(name) RSP_STATIC_TOKEN(RSP_TT_CHAR_CLASS, &(const char){ name }) // $name
+#define RSP_STATIC_SPAN(first, last) RSP_STATIC_CHAR(first), RSP_STATIC_CHAR("-"), RSP_STATIC_CHAR(last) // first-last inside a range
+
+// Node tokens
+#define RSP_STATIC_ZERO_PLUS(token) RSP_STATIC_TOKEN(RSP_TT_ZERO_PLUS, RSP_STATIC_SUB_PATTERN(token))                     // token*
+#define RSP_STATIC_ONE_PLUS(token) RSP_STATIC_TOKEN(RSP_TT_ONE_PLUS, RSP_STATIC_SUB_PATTERN(token))                       // token+
+#define RSP_STATIC_ONE_ZERO(token) RSP_STATIC_TOKEN(RSP_TT_ONE_ZERO, RSP_STATIC_SUB_PATTERN(token))                       // token?
+#define RSP_STATIC_POSITIVE_LOOKAHEAD(token) RSP_STATIC_TOKEN(RSP_TT_POSITIVE_LOOKAHEAD, RSP_STATIC_SUB_PATTERN(token))   // token!
+#define RSP_STATIC_NEGATIVE_LOOKAHEAD(token) RSP_STATIC_TOKEN(RSP_TT_NEGATIVE_LOOKAHEAD, RSP_STATIC_SUB_PATTERN(token))   // token~
+#define RSP_STATIC_RANGE(...) RSP_STATIC_TOKEN(RSP_TT_RANGE, RSP_STATIC_SUB_PATTERN(__VA_ARGS__))                         // [...]
+#define RSP_STATIC_NEG_RANGE(...) RSP_STATIC_TOKEN(RSP_TT_NEG_RANGE, RSP_STATIC_SUB_PATTERN(__VA_ARGS__))                 // [^...]
+#define RSP_STATIC_GROUP(...) RSP_STATIC_TOKEN(RSP_TT_GROUP, RSP_STATIC_SUB_PATTERN(__VA_ARGS__))                         // (...)
+
+// X-macro helpers, for tables of X(name, tokens...) entries
+#define RSP_STATIC_DEFINE(name, ...) static const struct rsp_pattern name = RSP_STATIC_PATTERN(__VA_ARGS__);
+#define RSP_STATIC_REFERENCE(name, ...) &name,
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Builds RSP in its default, LTO, PGO and LTO+PGO configurations and compares them on rsp_bench.
+# The PGO builds are instrumented (RSP_PGO=GENERATE), trained with rsp_bench over its corpora,
+# then rebuilt in the same build directory with the collected profile (RSP_PGO=USE).
+# Usage: scripts/pgo.sh [build root] [repetitions]
+set -e
+
+SOURCE_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_ROOT=${1:-$SOURCE_DIR/build-pgo}
+REPETITIONS=${2:-5}
+RUNS=${RUNS:-3}
+
+configure_and_build() {
+    dir=$1
+    shift
+    cmake -S "$SOURCE_DIR" -B "$dir" -DCMAKE_BUILD_TYPE=Release "$@" > /dev/null
+    cmake --build "$dir" --target rsp_bench > /dev/null
+}
+
+# Best total time of each variant over several runs, interleaved so a change in machine load hits every variant
+run_benches() {
+    for run in $(seq "$RUNS"); do
+        for variant in "$@"; do
+            echo "$variant $("$BUILD_ROOT/$variant/rsp_bench" "$REPETITIONS" | awk '/^total/ { print $2 }')"
+        done
+    done | awk '!($1 in best) || $2 < best[$1] { best[$1] = $2 } END { for (variant in best) print variant, best[variant] }'
+}
+
+build_pgo() {
+    dir=$1
+    shift
+    rm -rf "$dir/pgo"
+    configure_and_build "$dir" -DRSP_PGO=GENERATE "$@"
+    "$dir/rsp_bench" 1 > /dev/null
+    if ls "$dir"/pgo/*.profraw > /dev/null 2>&1; then
+        ${LLVM_PROFDATA:-llvm-profdata} merge -output="$dir/pgo/rsp.profdata" "$dir"/pgo/*.profraw
+    fi
+    configure_and_build "$dir" -DRSP_PGO=USE "$@"
+}
+
+configure_and_build "$BUILD_ROOT/default"
+configure_and_build "$BUILD_ROOT/lto" -DRSP_ENABLE_LTO=ON
+build_pgo "$BUILD_ROOT/pgo"
+build_pgo "$BUILD_ROOT/lto-pgo" -DRSP_ENABLE_LTO=ON
+
+BEST=$(run_benches default lto pgo lto-pgo)
+printf "%-10s %8s %8s\n" build seconds speedup
+for variant in default lto pgo lto-pgo; do
+    time=$(echo "$BEST" | awk -v variant="$variant" '$1 == variant { print $2 }')
+    baseline=${baseline:-$time}
+    printf "%-10s %8.3f %7.2fx\n" "$variant" "$time" "$(awk "BEGIN { print $baseline / $time }")"
+done
@@ -0,0 +1,162 @@
+#include <RSP/rsp.h>
+#include <RSP/lexer.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Benchmark of the matcher over three generated corpora, also used as the PGO training run.
+ * - source: C-like code lexed by the incremental lexer
+ * - log: log lines checked with forward, reverse and last-match searches
+ * - utf8: UTF-8 identifiers and strings lexed in UTF-8 mode
+ * Usage: rsp_bench [repetitions]
+ */
+
+#define BENCH_SOURCE_LINES 20000
+#define BENCH_LOG_LINES 40000
+
+static uint64_t bench_random_state = 0x853C49E6748FEA9Bull;
+
+static uint64_t bench_random(void) {
+    bench_random_state ^= bench_random_state << 13;
+    bench_random_state ^= bench_random_state >> 7;
+    bench_random_state ^= bench_random_state << 17;
+    return bench_random_state;
+}
+
+struct bench_buffer {
+    char * data;
+    size_t length;
+    size_t capacity;
+};
+
+static void bench_append(struct bench_buffer * buffer, const char * text) {
+    size_t length = strlen(text);
+    if (buffer->length + length + 1 > buffer->capacity) {
+        buffer->capacity = (buffer->length + length + 1) * 2;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+    memcpy(buffer->data + buffer->length, text, length + 1);
+    buffer->length += length;
+}
+
+static const char * bench_pick(const char * const * words, size_t count) {
+    return words[bench_random() % count];
+}
+
+static void bench_generate_source(struct bench_buffer * buffer, bool utf8) {
+    static const char * const ascii_words[] = { "value", "index_2", "compute", "_tmp", "buffer", "count", "rsp_match", "x" };
+    static const char * const utf8_words[] = { "valeur", "\xC3\xA9l\xC3\xA8ve", "\xCE\xB1\xCE\xB2\xCE\xB3", "\xE5\x8F\x98\xE9\x87\x8F", "na\xC3\xAFve_1", "x" };
+    static const char * const numbers[] = { "0", "42", "3.14f", "1000", "2.5", "7" };
+    static const char * const operators[] = { " = ", " + ", " * ", ", ", " - ", " / " };
+    static const char * const strings[] = { "\"text\"", "\"with \\\" quote\"", "\"\"", "\"longer string literal\"" };
+    static const char * const utf8_strings[] = { "\"caf\xC3\xA9\"", "\"\xE2\x82\xAC 5\"", "\"plain\"" };
+    for (size_t line = 0; line < BENCH_SOURCE_LINES; line++) {
+        bench_append(buffer, utf8 ? bench_pick(utf8_words, 6) : bench_pick(ascii_words, 8));
+        bench_append(buffer, " = ");
+        bench_append(buffer, utf8 ? bench_pick(utf8_words, 6) : bench_pick(ascii_words, 8));
+        bench_append(buffer, "(");
+        bench_append(buffer, bench_pick(numbers, 6));
+        bench_append(buffer, bench_pick(operators, 6));
+        bench_append(buffer, utf8 ? bench_pick(utf8_strings, 3) : bench_pick(strings, 4));
+        bench_append(buffer, ");\n");
+    }
+}
+
+static void bench_generate_log(struct bench_buffer * buffer) {
+    static const char * const levels[] = { "INFO", "WARN", "ERROR", "DEBUG" };
+    static const char * const messages[] = { "request served", "cache miss on key user_42", "disk usage high", "connection reset by peer" };
+    char line[160];
+    for (size_t i = 0; i < BENCH_LOG_LINES; i++) {
+        snprintf(line, sizeof(line), "2025-%02u-%02u 12:%02u:%02u [%s] %s took %ums\n",
+                 (unsigned)(1 + bench_random() % 12), (unsigned)(1 + bench_random() % 28),
+                 (unsigned)(bench_random() % 60), (unsigned)(bench_random() % 60),
+                 bench_pick(levels, 4), bench_pick(messages, 4), (unsigned)(bench_random() % 5000));
+        bench_append(buffer, line);
+    }
+}
+
+static struct rsp_lexer * bench_create_lexer(unsigned int flags) {
+    struct rsp_lexer * lexer = rsp_lexer_create();
+    rsp_lexer_add_rule(lexer, "[$a_][$w_]*[$w_]~", flags);
+    rsp_lexer_add_rule(lexer, "$d+$d~\\.?$d*$d~[fF]?", flags);
+    rsp_lexer_add_rule(lexer, "$s+$s~", flags);
+    rsp_lexer_add_rule(lexer, "\"(.*[\\\\\"]!(\\\\\")?\\\\?\\\\?)*\"", flags);
+    rsp_lexer_add_rule(lexer, "$p", flags);
+    return lexer;
+}
+
+static double bench_lex(const char * text, unsigned int flags, size_t repetitions, size_t * tokens) {
+    struct rsp_lexer * lexer = bench_create_lexer(flags);
+    clock_t start = clock();
+    for (size_t i = 0; i < repetitions; i++) {
+        struct rsp_lex_document * document = rsp_lex_document_create(lexer, text);
+        *tokens = document->token_count;
+        rsp_lex_document_free(document);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    rsp_lexer_free(lexer);
+    return seconds;
+}
+
+static double bench_log(const char * text, size_t repetitions, size_t * hits) {
+    struct rsp_pattern * timestamp = rsp_compile("$d$d$d$d-$d$d-$d$d $d$d:$d$d:$d$d \\[");
+    struct rsp_pattern * suffix = rsp_compile_with_flags("ms", RSP_CF_REVERSE);
+    struct rsp_pattern * number = rsp_compile_with_flags("$d+$d~", RSP_CF_REVERSE);
+    struct rsp_pattern * error = rsp_compile(".*(\\[ERROR\\])!");
+    clock_t start = clock();
+    for (size_t i = 0; i < repetitions; i++) {
+        *hits = 0;
+        for (const char * line = text; *line;) {
+            const char * end = strchr(line, '\n');
+            size_t length = (size_t)(end - line);
+            const char * number_end = NULL;
+            *hits += rsp_match(line, timestamp) != NULL;
+            *hits += rsp_match_reverse(line, length, suffix) != NULL;
+            *hits += rsp_rsearch(line, length, number, &number_end) != NULL;
+            *hits += rsp_match(line, error) != NULL;
+            line = end + 1;
+        }
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    rsp_free(timestamp);
+    rsp_free(suffix);
+    rsp_free(number);
+    rsp_free(error);
+    return seconds;
+}
+
+static void bench_report(const char * name, size_t bytes, size_t repetitions, double seconds, const char * unit, size_t count) {
+    double megabytes = (double)bytes * (double)repetitions / (1024.0 * 1024.0);
+    printf("%-8s %8.2f MB/s %8.3f s  (%zu %s)\n", name, seconds > 0 ? megabytes / seconds : 0, seconds, count, unit);
+}
+
+int main(int argc, char ** argv) {
+    size_t repetitions = argc > 1 ? strtoul(argv[1], NULL, 10) : 3;
+
+    struct bench_buffer source = { 0 };
+    struct bench_buffer log = { 0 };
+    struct bench_buffer utf8 = { 0 };
+    bench_generate_source(&source, false);
+    bench_generate_log(&log);
+    bench_generate_source(&utf8, true);
+
+    size_t count = 0;
+    double total = 0;
+    double seconds = bench_lex(source.data, RSP_CF_NONE, repetitions, &count);
+    bench_report("source", source.length, repetitions, seconds, "tokens", count);
+    total += seconds;
+    seconds = bench_log(log.data, repetitions, &count);
+    bench_report("log", log.length, repetitions, seconds, "hits", count);
+    total += seconds;
+    seconds = bench_lex(utf8.data, RSP_CF_UTF8, repetitions, &count);
+    bench_report("utf8", utf8.length, repetitions, seconds, "tokens", count);
+    total += seconds;
+    printf("total    %.3f s\n", total);
+
+    free(source.data);
+    free(log.data);
+    free(utf8.data);
+    return 0;
+}
@@ -0,0 +1,582 @@
+#include <RSP/rsp.h>
+#include <regex.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Differential test of RSP against a reference matcher and POSIX extended regular expressions.
+ * The reference matcher walks a syntax tree generated along with each pattern and implements the
+ * RSP semantics directly: repetitions are lazy and never backtrack, stopping at the end of the
+ * input or where the next element of their sequence can start, '?' takes its atom when it matches,
+ * and '!' / '~' test their atom without consuming it.
+ * Half of the patterns use the full syntax (groups, '?', quantifiers anywhere and lookaheads) and
+ * are only compared with the reference. The other half stay in the subset where POSIX agrees:
+ * literals, '.', classes and ranges, with an optional quantifier on the last atom (a trailing
+ * '*' or '+' runs to the end of the input), compared with both.
+ * Forward matches are compared with "^..." and reversed matches with "...$", the reference
+ * taking the leftmost start whose forward match ends the subject.
+ * Throughput is then measured on a fixed corpus and set of subset patterns, independent of the
+ * seed, each engine timed over the whole corpus at once, and appended to throughput.csv.
+ * Usage: rsp_differential [iterations] [seed] [throughput.csv]
+ */
+
+#define DIFF_MAX_ATOMS 6
+#define DIFF_MAX_MEMBERS 3
+#define DIFF_MAX_SEQUENCES 4
+#define DIFF_MAX_SUBJECT 12
+#define DIFF_SUBJECTS_PER_PATTERN 64
+#define DIFF_THROUGHPUT_SEED 0x9E3779B97F4A7C15ull
+#define DIFF_THROUGHPUT_PATTERNS 64
+#define DIFF_THROUGHPUT_LINES 4096
+#define DIFF_THROUGHPUT_LINE 64
+#define DIFF_THROUGHPUT_PASSES 8
+
+enum diff_atom_type {
+    DIFF_LITERAL,
+    DIFF_ANY,
+    DIFF_CLASS,
+    DIFF_SET,
+    DIFF_GROUP
+};
+
+/**
+ * @brief Member of a bracket: a class when class_name is set, the span from first to last otherwise.
+ */
+struct diff_member {
+    char class_name;
+    char first;
+    char last;
+};
+
+/**
+ * @brief Atom of a pattern with the operator following it: '\0', '*', '+', '?', '!' or '~'.
+ */
+struct diff_element {
+    enum diff_atom_type type;
+    char value;                 // Literal byte or class name
+    bool negated;               // Bracket starting with '^'
+    size_t member_count;
+    struct diff_member members[DIFF_MAX_MEMBERS];
+    size_t group;               // Index of the sequence of a group
+    char modifier;
+};
+
+struct diff_sequence {
+    size_t count;
+    struct diff_element elements[DIFF_MAX_ATOMS];
+};
+
+struct diff_case {
+    char rsp[512];
+    char posix[512];
+    bool quantified;
+    bool shared;                // Pattern in the subset POSIX agrees on
+    size_t sequence_count;
+    struct diff_sequence sequences[DIFF_MAX_SEQUENCES];     // The pattern first, then its groups
+};
+
+static uint64_t diff_random_state;
+
+static uint64_t diff_random(void) {
+    diff_random_state ^= diff_random_state << 13;
+    diff_random_state ^= diff_random_state >> 7;
+    diff_random_state ^= diff_random_state << 17;
+    return diff_random_state;
+}
+
+static char diff_pick(const char * set) {
+    return set[diff_random() % strlen(set)];
+}
+
+static void diff_append(char * buffer, const char * text) {
+    strcat(buffer, text);
+}
+
+static void diff_append_char(char * buffer, char c) {
+    size_t length = strlen(buffer);
+    buffer[length] = c;
+    buffer[length + 1] = '\0';
+}
+
+static const char * diff_posix_class(char name, bool in_bracket) {
+    switch (name) {
+        case 'a': return in_bracket ? "[:alpha:]" : "[[:alpha:]]";
+        case 'd': return in_bracket ? "[:digit:]" : "[[:digit:]]";
+        case 'w': return in_bracket ? "[:alnum:]_" : "[[:alnum:]_]";
+        case 's': return in_bracket ? "[:space:]" : "[[:space:]]";
+        case 'x': return in_bracket ? "[:xdigit:]" : "[[:xdigit:]]";
+        case 'p': return in_bracket ? "[:punct:]" : "[[:punct:]]";
+        default: return "_";
+    }
+}
+
+static void diff_generate_bracket(struct diff_case * test_case, struct diff_element * element) {
+    bool negated = diff_random() % 3 == 0;
+    diff_append(test_case->rsp, negated ? "[^" : "[");
+    diff_append(test_case->posix, negated ? "[^" : "[");
+    element->type = DIFF_SET;
+    element->negated = negated;
+    element->member_count = 1 + diff_random() % DIFF_MAX_MEMBERS;
+    for (size_t i = 0; i < element->member_count; i++) {
+        struct diff_member * member = &element->members[i];
+        member->class_name = '\0';
+        switch (diff_random() % 3) {
+            case 0: {
+                char c = diff_pick("abcxyzABC019_");
+                diff_append_char(test_case->rsp, c);
+                diff_append_char(test_case->posix, c);
+                member->first = c;
+                member->last = c;
+                break;
+            }
+            case 1: {
+                static const char * const spans[] = { "abcdefxyz", "ABCXYZ", "0123456789" };
+                const char * span = spans[diff_random() % 3];
+                size_t first = diff_random() % strlen(span);
+                size_t last = first + diff_random() % (strlen(span) - first);
+                char text[4] = { span[first], '-', span[last], '\0' };
+                diff_append(test_case->rsp, text);
+                diff_append(test_case->posix, text);
+                member->first = span[first];
+                member->last = span[last];
+                break;
+            }
+            default: {
+                char name = diff_pick("adwsxp_");
+                char text[3] = { '$', name, '\0' };
+                diff_append(test_case->rsp, text);
+                diff_append(test_case->posix, diff_posix_class(name, true));
+                member->class_name = name;
+                break;
+            }
+        }
+    }
+    diff_append(test_case->rsp, "]");
+    diff_append(test_case->posix, "]");
+}
+
+/**
+ * @brief Appends a random atom other than a group to both syntaxes.
+ */
+static void diff_generate_atom(struct diff_case * test_case, struct diff_element * element) {
+    element->modifier = '\0';
+    switch (diff_random() % 4) {
+        case 0: {
+            char c = diff_pick("abcxyz019_ .-@");
+            if (c == '.') {
+                diff_append(test_case->rsp, "\\.");
+                diff_append(test_case->posix, "\\.");
+            } else {
+                diff_append_char(test_case->rsp, c);
+                diff_append_char(test_case->posix, c);
+            }
+            element->type = DIFF_LITERAL;
+            element->value = c;
+            break;
+        }
+        case 1:
+            diff_append(test_case->rsp, ".");
+            diff_append(test_case->posix, ".");
+            element->type = DIFF_ANY;
+            break;
+        case 2: {
+            char name = diff_pick("adwsxp_");
+            char text[3] = { '$', name, '\0' };
+            diff_append(test_case->rsp, text);
+            diff_append(test_case->posix, diff_posix_class(name, false));
+            element->type = DIFF_CLASS;
+            element->value = name;
+            break;
+        }
+        default:
+            diff_generate_bracket(test_case, element);
+            break;
+    }
+}
+
+static void diff_generate(struct diff_case * test_case, bool allow_quantifier) {
+    test_case->rsp[0] = '\0';
+    test_case->posix[0] = '\0';
+    test_case->quantified = false;
+    test_case->shared = true;
+    test_case->sequence_count = 1;
+    struct diff_sequence * sequence = &test_case->sequences[0];
+    sequence->count = 1 + diff_random() % DIFF_MAX_ATOMS;
+    for (size_t i = 0; i < sequence->count; i++) {
+        diff_generate_atom(test_case, &sequence->elements[i]);
+    }
+    if (allow_quantifier && diff_random() % 3 == 0) {
+        char quantifier = diff_pick("*+?");
+        diff_append_char(test_case->rsp, quantifier);
+        diff_append_char(test_case->posix, quantifier);
+        test_case->quantified = quantifier != '?';
+        sequence->elements[sequence->count - 1].modifier = quantifier;
+    }
+}
+
+/**
+ * @brief Generates a sequence of the full syntax into sequences[index], nesting groups up to depth 2.
+ */
+static void diff_generate_sequence(struct diff_case * test_case, size_t index, size_t depth) {
+    struct diff_sequence * sequence = &test_case->sequences[index];
+    sequence->count = 1 + diff_random() % (depth == 0 ? DIFF_MAX_ATOMS : 3);
+    for (size_t i = 0; i < sequence->count; i++) {
+        struct diff_element * element = &sequence->elements[i];
+        if (depth < 2 && test_case->sequence_count < DIFF_MAX_SEQUENCES && diff_random() % 5 == 0) {
+            element->type = DIFF_GROUP;
+            element->group = test_case->sequence_count++;
+            diff_append(test_case->rsp, "(");
+            diff_generate_sequence(test_case, element->group, depth + 1);
+            diff_append(test_case->rsp, ")");
+        } else {
+            diff_generate_atom(test_case, element);
+        }
+        element->modifier = diff_random() % 2 == 0 ? '\0' : diff_pick("*+?!~");
+        if (element->modifier != '\0') {
+            diff_append_char(test_case->rsp, element->modifier);
+        }
+    }
+}
+
+static void diff_generate_full(struct diff_case * test_case) {
+    test_case->rsp[0] = '\0';
+    test_case->posix[0] = '\0';
+    test_case->quantified = false;
+    test_case->shared = false;
+    test_case->sequence_count = 1;
+    diff_generate_sequence(test_case, 0, 0);
+}
+
+static void diff_generate_subject(char * subject, size_t max_length) {
+    size_t length = diff_random() % (max_length + 1);
+    for (size_t i = 0; i < length; i++) {
+        subject[i] = diff_pick("abcxyzABC019_ .-@\t\xE9");
+    }
+    subject[length] = '\0';
+}
+
+static bool diff_in_class(char name, char c) {
+    bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    bool digit = c >= '0' && c <= '9';
+    switch (name) {
+        case 'a': return alpha;
+        case 'd': return digit;
+        case 'w': return alpha || digit || c == '_';
+        case '_': return c == '_';
+        case 's': return c == ' ' || (c >= '\t' && c <= '\r');
+        case 'x': return digit || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        case 'p': return c > ' ' && c < 0x7F && !alpha && !digit;
+        default: return false;
+    }
+}
+
+static bool diff_reference_sequence(const struct diff_case * test_case, const struct diff_sequence * sequence, const char * subject, size_t * position);
+
+/**
+ * @brief Matches an atom at position, moving position past it on success.
+ */
+static bool diff_reference_atom(const struct diff_case * test_case, const struct diff_element * element, const char * subject, size_t * position) {
+    char c = subject[*position];
+    switch (element->type) {
+        case DIFF_LITERAL:
+            if (c != element->value) {
+                return false;
+            }
+            break;
+        case DIFF_ANY:
+            if (c == '\0') {
+                return false;
+            }
+            break;
+        case DIFF_CLASS:
+            if (c == '\0' || !diff_in_class(element->value, c)) {
+                return false;
+            }
+            break;
+        case DIFF_SET: {
+            if (c == '\0') {
+                return false;
+            }
+            bool member = false;
+            for (size_t i = 0; i < element->member_count; i++) {
+                const struct diff_member * candidate = &element->members[i];
+                if (candidate->class_name != '\0' ? diff_in_class(candidate->class_name, c)
+                                                   : (unsigned char)c >= (unsigned char)candidate->first && (unsigned char)c <= (unsigned char)candidate->last) {
+                    member = true;
+                }
+            }
+            if (member == element->negated) {
+                return false;
+            }
+            break;
+        }
+        case DIFF_GROUP:
+            return diff_reference_sequence(test_case, &test_case->sequences[element->group], subject, position);
+    }
+    (*position)++;
+    return true;
+}
+
+static bool diff_reference_element(const struct diff_case * test_case, const struct diff_sequence * sequence, size_t index, const char * subject, size_t * position);
+
+/**
+ * @brief Tells whether the element at index can start at position, which stops a repetition before it.
+ * A repetition only takes its first step: '*' starts at the end of the input, where its own next
+ * element starts or where its atom matches, '+' where its atom matches.
+ */
+static bool diff_reference_starts(const struct diff_case * test_case, const struct diff_sequence * sequence, size_t index, const char * subject, size_t position) {
+    const struct diff_element * element = &sequence->elements[index];
+    size_t next = position;
+    switch (element->modifier) {
+        case '*':
+            if (subject[position] == '\0' || (index + 1 < sequence->count && diff_reference_starts(test_case, sequence, index + 1, subject, position))) {
+                return true;
+            }
+            return diff_reference_atom(test_case, element, subject, &next);
+        case '+':
+            return diff_reference_atom(test_case, element, subject, &next);
+        default:
+            return diff_reference_element(test_case, sequence, index, subject, &next);
+    }
+}
+
+/**
+ * @brief Matches the element at index of a sequence, with its operator, at position.
+ */
+static bool diff_reference_element(const struct diff_case * test_case, const struct diff_sequence * sequence, size_t index, const char * subject, size_t * position) {
+    const struct diff_element * element = &sequence->elements[index];
+    size_t next = *position;
+    switch (element->modifier) {
+        case '?':
+            if (diff_reference_atom(test_case, element, subject, &next)) {
+                *position = next;
+            }
+            return true;
+        case '!':
+        case '~':
+            return diff_reference_atom(test_case, element, subject, &next) == (element->modifier == '!');
+        case '*':
+        case '+':
+            for (size_t count = 0;; count++) {
+                if (element->modifier == '*' || count > 0) {
+                    // Stop at the end of the input or where the next element of the sequence can start
+                    if (subject[*position] == '\0' ||
+                        (index + 1 < sequence->count && diff_reference_starts(test_case, sequence, index + 1, subject, *position))) {
+                        return true;
+                    }
+                }
+                next = *position;
+                if (!diff_reference_atom(test_case, element, subject, &next)) {
+                    return false;
+                }
+                if (next == *position) {
+                    return true;
+                }
+                *position = next;
+            }
+        default:
+            if (!diff_reference_atom(test_case, element, subject, &next)) {
+                return false;
+            }
+            *position = next;
+            return true;
+    }
+}
+
+static bool diff_reference_sequence(const struct diff_case * test_case, const struct diff_sequence * sequence, const char * subject, size_t * position) {
+    size_t current = *position;
+    for (size_t i = 0; i < sequence->count; i++) {
+        if (!diff_reference_element(test_case, sequence, i, subject, &current)) {
+            return false;
+        }
+    }
+    *position = current;
+    return true;
+}
+
+/**
+ * @brief Offset of the end of a forward match, or of the leftmost start of a match ending the subject in reverse, -1 without a match.
+ */
+static long diff_reference_match(const struct diff_case * test_case, const char * subject, size_t length, bool reverse) {
+    for (size_t start = 0; start <= (reverse ? length : 0); start++) {
+        size_t position = start;
+        if (diff_reference_sequence(test_case, &test_case->sequences[0], subject, &position) && (!reverse || position == length)) {
+            return reverse ? (long)start : (long)position;
+        }
+    }
+    return -1;
+}
+
+struct diff_throughput {
+    double rsp_seconds;
+    double posix_seconds;
+    double megabytes;
+};
+
+/**
+ * @brief Times both engines on forward subset patterns over several passes of a fixed corpus of lines.
+ * @return false if POSIX rejected a translated pattern or the engines disagree on the number of matches.
+ */
+static bool diff_measure_throughput(struct diff_throughput * throughput) {
+    diff_random_state = DIFF_THROUGHPUT_SEED;
+    static char lines[DIFF_THROUGHPUT_LINES][DIFF_THROUGHPUT_LINE + 1];
+    size_t bytes = 0;
+    for (size_t k = 0; k < DIFF_THROUGHPUT_LINES; k++) {
+        diff_generate_subject(lines[k], DIFF_THROUGHPUT_LINE);
+        bytes += strlen(lines[k]);
+    }
+    // Compiled patterns point into their source, which must outlive them
+    static struct diff_case cases[DIFF_THROUGHPUT_PATTERNS];
+    struct rsp_pattern * patterns[DIFF_THROUGHPUT_PATTERNS];
+    regex_t regexes[DIFF_THROUGHPUT_PATTERNS];
+    size_t count = 0;
+    bool accepted = true;
+    while (count < DIFF_THROUGHPUT_PATTERNS) {
+        struct diff_case * test_case = &cases[count];
+        char anchored[520] = "^";
+        diff_generate(test_case, true);
+        strcat(anchored, test_case->posix);
+        strcat(anchored, test_case->quantified ? "$" : "");
+        if (regcomp(&regexes[count], anchored, REG_EXTENDED) != 0) {
+            printf("[DIFF] POSIX rejected \"%s\" translated from \"%s\"\n", anchored, test_case->rsp);
+            accepted = false;
+            break;
+        }
+        patterns[count++] = rsp_compile(test_case->rsp);
+    }
+
+    size_t rsp_hits = 0;
+    size_t posix_hits = 0;
+    regmatch_t match;
+    clock_t start = clock();
+    for (size_t pass = 0; pass < DIFF_THROUGHPUT_PASSES; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            for (size_t k = 0; k < DIFF_THROUGHPUT_LINES; k++) {
+                rsp_hits += rsp_match(lines[k], patterns[i]) != NULL;
+            }
+        }
+    }
+    throughput->rsp_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    for (size_t pass = 0; pass < DIFF_THROUGHPUT_PASSES; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            for (size_t k = 0; k < DIFF_THROUGHPUT_LINES; k++) {
+                posix_hits += regexec(&regexes[i], lines[k], 1, &match, 0) == 0;
+            }
+        }
+    }
+    throughput->posix_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    throughput->megabytes = (double)bytes * (double)count * DIFF_THROUGHPUT_PASSES / (1024.0 * 1024.0);
+    if (rsp_hits != posix_hits) {
+        printf("[DIFF] throughput corpus: RSP %zu matches, POSIX %zu\n", rsp_hits, posix_hits);
+        accepted = false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        rsp_free(patterns[i]);
+        regfree(&regexes[i]);
+    }
+    return accepted;
+}
+
+int main(int argc, char ** argv) {
+    size_t iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    diff_random_state = argc > 2 ? strtoull(argv[2], NULL, 10) : 0x2545F4914F6CDD1Dull;
+    if (diff_random_state == 0) {
+        diff_random_state = 1;
+    }
+    const char * record_path = argc > 3 ? argv[3] : NULL;
+
+    size_t failures = 0;
+    char anchored[520];
+
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        bool reverse = iteration % 2 == 1;
+        struct diff_case test_case;
+        if (iteration % 4 < 2) {
+            diff_generate(&test_case, !reverse);
+        } else {
+            diff_generate_full(&test_case);
+        }
+
+        regex_t regex;
+        if (test_case.shared) {
+            strcpy(anchored, reverse ? "" : "^");
+            strcat(anchored, test_case.posix);
+            strcat(anchored, (reverse || test_case.quantified) ? "$" : "");
+            if (regcomp(&regex, anchored, REG_EXTENDED) != 0) {
+                printf("[DIFF] POSIX rejected \"%s\" translated from \"%s\"\n", anchored, test_case.rsp);
+                failures++;
+                continue;
+            }
+        }
+        struct rsp_pattern * pattern = rsp_compile_with_flags(test_case.rsp, reverse ? RSP_CF_REVERSE : RSP_CF_NONE);
+
+        char subjects[DIFF_SUBJECTS_PER_PATTERN][DIFF_MAX_SUBJECT + 1];
+        size_t lengths[DIFF_SUBJECTS_PER_PATTERN];
+        const char * results[DIFF_SUBJECTS_PER_PATTERN];
+        regmatch_t matches[DIFF_SUBJECTS_PER_PATTERN];
+        bool posix_matched[DIFF_SUBJECTS_PER_PATTERN];
+        for (size_t k = 0; k < DIFF_SUBJECTS_PER_PATTERN; k++) {
+            diff_generate_subject(subjects[k], DIFF_MAX_SUBJECT);
+            lengths[k] = strlen(subjects[k]);
+        }
+
+        for (size_t k = 0; k < DIFF_SUBJECTS_PER_PATTERN; k++) {
+            results[k] = reverse ? rsp_match_reverse(subjects[k], lengths[k], pattern) : rsp_match(subjects[k], pattern);
+            posix_matched[k] = test_case.shared && regexec(&regex, subjects[k], 1, &matches[k], 0) == 0;
+        }
+
+        for (size_t k = 0; k < DIFF_SUBJECTS_PER_PATTERN; k++) {
+            long rsp_offset = results[k] ? (long)(results[k] - subjects[k]) : -1;
+            long reference_offset = diff_reference_match(&test_case, subjects[k], lengths[k], reverse);
+            if (rsp_offset != reference_offset) {
+                printf("[DIFF] %s \"%s\" on \"%s\": RSP %ld, reference %ld\n",
+                       reverse ? "reverse" : "forward", test_case.rsp, subjects[k], rsp_offset, reference_offset);
+                failures++;
+            }
+            if (!test_case.shared) {
+                continue;
+            }
+            long posix_offset = posix_matched[k] ? (long)(reverse ? matches[k].rm_so : matches[k].rm_eo) : -1;
+            if (rsp_offset != posix_offset) {
+                printf("[DIFF] %s \"%s\" (POSIX \"%s\") on \"%s\": RSP %ld, POSIX %ld\n",
+                       reverse ? "reverse" : "forward", test_case.rsp, anchored, subjects[k], rsp_offset, posix_offset);
+                failures++;
+            }
+        }
+        rsp_free(pattern);
+        if (test_case.shared) {
+            regfree(&regex);
+        }
+    }
+
+    size_t cases = iterations * DIFF_SUBJECTS_PER_PATTERN;
+    printf("Compared %zu matches, %zu differences\n", cases, failures);
+
+    struct diff_throughput throughput;
+    if (!diff_measure_throughput(&throughput)) {
+        failures++;
+    }
+    double rsp_throughput = throughput.rsp_seconds > 0 ? throughput.megabytes / throughput.rsp_seconds : 0;
+    double posix_throughput = throughput.posix_seconds > 0 ? throughput.megabytes / throughput.posix_seconds : 0;
+    printf("Throughput over %.2f MB: RSP %.2f MB/s (%.3f s), POSIX %.2f MB/s (%.3f s)\n",
+           throughput.megabytes, rsp_throughput, throughput.rsp_seconds, posix_throughput, throughput.posix_seconds);
+    if (record_path != NULL) {
+        FILE * record = fopen(record_path, "a");
+        if (record != NULL) {
+            fseek(record, 0, SEEK_END);
+            if (ftell(record) == 0) {
+                fprintf(record, "cases,differences,rsp_seconds,posix_seconds,rsp_mb_per_s,posix_mb_per_s\n");
+            }
+            fprintf(record, "%zu,%zu,%.6f,%.6f,%.3f,%.3f\n", cases, failures, throughput.rsp_seconds, throughput.posix_seconds, rsp_throughput, posix_throughput);
+            fclose(record);
+        } else {
+            printf("Cannot write %s\n", record_path);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <RSP/rsp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Fuzz target for rsp_compile() and the match functions.
+ * The first byte selects the compile flags, the rest is the pattern, a NUL byte, then the subject.
+ * Built against libFuzzer with Clang (RSP_BUILD_FUZZER), or as a standalone driver replaying
+ * files or random inputs otherwise.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    unsigned int flags = data[0] & (RSP_CF_UTF8 | RSP_CF_REVERSE);
+    data++;
+    size--;
+
+    const uint8_t * separator = memchr(data, '\0', size);
+    size_t pattern_length = separator ? (size_t)(separator - data) : size;
+    size_t subject_length = separator ? size - pattern_length - 1 : 0;
+    char * pattern_source = malloc(pattern_length + 1);
+    char * subject = malloc(subject_length + 1);
+    memcpy(pattern_source, data, pattern_length);
+    pattern_source[pattern_length] = '\0';
+    if (subject_length > 0) {
+        memcpy(subject, separator + 1, subject_length);
+    }
+    subject[subject_length] = '\0';
+
+    struct rsp_pattern * pattern = rsp_compile_with_flags(pattern_source, flags);
+    if (pattern == NULL) {
+        // Reversed patterns repeating an operator are rejected when compiled
+        free(subject);
+        free(pattern_source);
+        return 0;
+    }
+    if (flags & RSP_CF_REVERSE) {
+        // Bound the buffer by its length only, so reading past it is caught
+        char * buffer = malloc(subject_length ? subject_length : 1);
+        memcpy(buffer, subject, subject_length);
+        const char * end = NULL;
+        const char * start = rsp_match_reverse(buffer, subject_length, pattern);
+        const char * last = rsp_rsearch(buffer, subject_length, pattern, &end);
+        // Reverse matching finds the leftmost start a forward run would end the subject from
+        if (memchr(subject, '\0', subject_length) == NULL) {
+            struct rsp_pattern * forward = rsp_compile_with_flags(pattern_source, flags & ~RSP_CF_REVERSE);
+            for (size_t k = 0; k <= subject_length; k++) {
+                bool inside_codepoint = (flags & RSP_CF_UTF8) && k > 0 && k < subject_length && ((unsigned char)subject[k] & 0xC0) == 0x80;
+                if (!inside_codepoint && rsp_match(subject + k, forward) == subject + subject_length) {
+                    if (start != buffer + k) {
+                        abort();
+                    }
+                    break;
+                }
+                if (start == buffer + k) {
+                    abort();
+                }
+            }
+            // The last match ends the furthest of all forward matches, from the leftmost start on ties
+            const char * furthest = NULL;
+            size_t furthest_start = 0;
+            for (size_t k = 0; k <= subject_length; k++) {
+                bool inside_codepoint = (flags & RSP_CF_UTF8) && k > 0 && k < subject_length && ((unsigned char)subject[k] & 0xC0) == 0x80;
+                const char * match = inside_codepoint ? NULL : rsp_match(subject + k, forward);
+                if (match != NULL && (furthest == NULL || match > furthest)) {
+                    furthest = match;
+                    furthest_start = k;
+                }
+            }
+            if ((furthest == NULL) != (last == NULL) || (last != NULL && (last != buffer + furthest_start || end != buffer + (furthest - subject)))) {
+                abort();
+            }
+            rsp_free(forward);
+        }
+        free(buffer);
+    } else {
+        const char * reach = NULL;
+        const char * result = rsp_match(subject, pattern);
+        const char * result_with_reach = rsp_match_with_reach(subject, pattern, &reach);
+        if (result != result_with_reach || reach > subject + subject_length + 4) {
+            abort();
+        }
+    }
+    rsp_free(pattern);
+
+    free(subject);
+    free(pattern_source);
+    return 0;
+}
+
+#ifdef RSP_FUZZ_STANDALONE
+
+static uint64_t fuzz_random_state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t fuzz_random(void) {
+    fuzz_random_state ^= fuzz_random_state << 13;
+    fuzz_random_state ^= fuzz_random_state >> 7;
+    fuzz_random_state ^= fuzz_random_state << 17;
+    return fuzz_random_state;
+}
+
+static int fuzz_file(const char * path) {
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+    uint8_t * data = NULL;
+    size_t size = 0;
+    uint8_t chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data = realloc(data, size + read);
+        memcpy(data + size, chunk, read);
+        size += read;
+    }
+    fclose(file);
+    LLVMFuzzerTestOneInput(data, size);
+    free(data);
+    return 0;
+}
+
+int main(int argc, char ** argv) {
+    if (argc > 1) {
+        int status = 0;
+        for (int i = 1; i < argc; i++) {
+            status |= fuzz_file(argv[i]);
+        }
+        return status;
+    }
+    // Without inputs, run random pattern-like inputs
+    static const char alphabet[] = "ab_1 .*+?!~$[]^()-\\\\adwsxp\0\xC3\xA9\xFF";
+    const size_t iterations = 200000;
+    uint8_t input[48];
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        size_t size = 1 + fuzz_random() % sizeof(input);
+        input[0] = (uint8_t)fuzz_random();
+        for (size_t i = 1; i < size; i++) {
+            input[i] = (uint8_t)alphabet[fuzz_random() % (sizeof(alphabet) - 1)];
+        }
+        LLVMFuzzerTestOneInput(input, size);
+    }
+    printf("Ran %zu random inputs\n", iterations);
+    return 0;
+}
+
+#endif
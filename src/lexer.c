@@ -0,0 +1,326 @@
+#include <RSP/lexer.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct rsp_lexer * rsp_lexer_create(void) {
+    struct rsp_lexer * lexer = malloc(sizeof(struct rsp_lexer));
+    lexer->rules = NULL;
+    lexer->rule_count = 0;
+    return lexer;
+}
+
+void rsp_lexer_free(struct rsp_lexer * lexer) {
+    for (size_t i = 0; i < lexer->rule_count; i++) {
+        if (lexer->rules[i].compiled != NULL) {
+            rsp_free(lexer->rules[i].compiled);
+        }
+        free(lexer->rules[i].source);
+    }
+    free(lexer->rules);
+    free(lexer);
+}
+
+static size_t rsp_lexer_push_rule(struct rsp_lexer * lexer, struct rsp_lex_rule rule) {
+    lexer->rules = realloc(lexer->rules, sizeof(struct rsp_lex_rule) * (lexer->rule_count + 1));
+    lexer->rules[lexer->rule_count] = rule;
+    return lexer->rule_count++;
+}
+
+size_t rsp_lexer_add_rule(struct rsp_lexer * lexer, const char * pattern, unsigned int flags) {
+    size_t length = strlen(pattern);
+    char * source = malloc(length + 1);
+    memcpy(source, pattern, length + 1);
+    struct rsp_pattern * compiled = rsp_compile_with_flags(source, flags);
+    return rsp_lexer_push_rule(lexer, (struct rsp_lex_rule) {
+        .source = source,
+        .compiled = compiled,
+        .pattern = compiled
+    });
+}
+
+size_t rsp_lexer_add_static_rule(struct rsp_lexer * lexer, const struct rsp_pattern * pattern) {
+    return rsp_lexer_push_rule(lexer, (struct rsp_lex_rule) {
+        .source = NULL,
+        .compiled = NULL,
+        .pattern = pattern
+    });
+}
+
+/**
+ * @brief Lexes the token starting at offset.
+ * Bytes no rule matches become single byte RSP_LEX_NO_RULE tokens, so lexing always progresses.
+ */
+static void rsp_lex_token_at(const struct rsp_lexer * lexer, const char * text, size_t offset, struct rsp_lex_token * token) {
+    const char * start = text + offset;
+    const char * reach = start;
+    token->rule = RSP_LEX_NO_RULE;
+    token->offset = offset;
+    token->length = 1;
+    for (size_t i = 0; i < lexer->rule_count; i++) {
+        const char * rule_reach;
+        const char * end = rsp_match_with_reach(start, lexer->rules[i].pattern, &rule_reach);
+        if (rule_reach > reach) {
+            reach = rule_reach;
+        }
+        if (end != NULL && end > start) {
+            token->rule = i;
+            token->length = (size_t)(end - start);
+            break;
+        }
+    }
+    if (reach < start + token->length) {
+        reach = start + token->length;
+    }
+    token->lookahead = (size_t)(reach - (start + token->length));
+}
+
+static size_t rsp_lex_token_reach(const struct rsp_lex_token * token) {
+    return token->offset + token->length + token->lookahead;
+}
+
+/**
+ * @brief Returns the histogram bucket of a lookahead, its bit length.
+ */
+static size_t rsp_lex_lookahead_bucket(size_t lookahead) {
+    size_t bucket = 0;
+    while (lookahead > 0) {
+        lookahead >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Returns a bound on the lookahead of every token of the document.
+ */
+static size_t rsp_lex_max_lookahead(const struct rsp_lex_document * document) {
+    for (size_t bucket = RSP_LEX_LOOKAHEAD_BUCKETS; bucket > 0; bucket--) {
+        if (document->lookahead_counts[bucket - 1] > 0) {
+            return bucket - 1 >= sizeof(size_t) * 8 ? (size_t)-1 : ((size_t)1 << (bucket - 1)) - 1;
+        }
+    }
+    return 0;
+}
+
+struct rsp_lex_token rsp_lex_document_token(const struct rsp_lex_document * document, size_t index) {
+    if (index < document->token_gap_start) {
+        return document->tokens[index];
+    }
+    struct rsp_lex_token token = document->tokens[index + document->token_gap_length];
+    token.offset = document->length - token.offset;
+    return token;
+}
+
+/**
+ * @brief Inserts a token at the gap, growing the buffer when the gap is empty.
+ */
+static void rsp_lex_insert_token(struct rsp_lex_document * document, struct rsp_lex_token token) {
+    if (document->token_gap_length == 0) {
+        size_t capacity = document->token_capacity ? document->token_capacity << 1 : 16;
+        size_t tail = document->token_capacity - document->token_gap_start;
+        document->tokens = realloc(document->tokens, sizeof(struct rsp_lex_token) * capacity);
+        if (tail > 0) {
+            memmove(document->tokens + capacity - tail, document->tokens + document->token_gap_start, sizeof(struct rsp_lex_token) * tail);
+        }
+        document->token_gap_length = capacity - document->token_capacity;
+        document->token_capacity = capacity;
+    }
+    document->tokens[document->token_gap_start++] = token;
+    document->token_gap_length--;
+    document->token_count++;
+    document->lookahead_counts[rsp_lex_lookahead_bucket(token.lookahead)]++;
+}
+
+/**
+ * @brief Removes the token following the gap.
+ */
+static void rsp_lex_remove_token(struct rsp_lex_document * document) {
+    document->lookahead_counts[rsp_lex_lookahead_bucket(document->tokens[document->token_gap_start + document->token_gap_length].lookahead)]--;
+    document->token_gap_length++;
+    document->token_count--;
+}
+
+/**
+ * @brief Moves the gap before the token at index, converting the offsets of the tokens crossing it.
+ * @return The number of tokens moved, the distance between the gap and index.
+ * @note The previous edit is usually close, so few tokens are moved.
+ */
+static size_t rsp_lex_move_gap(struct rsp_lex_document * document, size_t index) {
+    size_t moved = document->token_gap_start > index ? document->token_gap_start - index : index - document->token_gap_start;
+    while (document->token_gap_start > index) {
+        document->token_gap_start--;
+        struct rsp_lex_token * token = &document->tokens[document->token_gap_start + document->token_gap_length];
+        *token = document->tokens[document->token_gap_start];
+        token->offset = document->length - token->offset;
+    }
+    while (document->token_gap_start < index) {
+        struct rsp_lex_token * token = &document->tokens[document->token_gap_start];
+        *token = document->tokens[document->token_gap_start + document->token_gap_length];
+        token->offset = document->length - token->offset;
+        document->token_gap_start++;
+    }
+    return moved;
+}
+
+/**
+ * @brief Moves the gap of the text to offset.
+ * @return The number of bytes moved.
+ */
+static size_t rsp_lex_move_text_gap(struct rsp_lex_document * document, size_t offset) {
+    char * gap = document->text + document->text_gap_start;
+    size_t moved = 0;
+    if (offset < document->text_gap_start) {
+        moved = document->text_gap_start - offset;
+        memmove(gap + document->text_gap_length - moved, gap - moved, moved);
+    } else if (offset > document->text_gap_start) {
+        moved = offset - document->text_gap_start;
+        memmove(gap, gap + document->text_gap_length, moved);
+    }
+    document->text_gap_start = offset;
+    return moved;
+}
+
+/**
+ * @brief Grows the gap of the text to at least length bytes.
+ * @return The number of bytes moved, the text after the gap when the buffer grows.
+ */
+static size_t rsp_lex_reserve_text(struct rsp_lex_document * document, size_t length) {
+    if (document->text_gap_length >= length) {
+        return 0;
+    }
+    size_t capacity = document->text_capacity << 1;
+    if (capacity < document->text_capacity + length - document->text_gap_length) {
+        capacity = document->text_capacity + length - document->text_gap_length;
+    }
+    size_t tail = document->text_capacity - document->text_gap_start - document->text_gap_length;
+    document->text = realloc(document->text, capacity);
+    memmove(document->text + capacity - tail, document->text + document->text_gap_start + document->text_gap_length, tail);
+    document->text_gap_length += capacity - document->text_capacity;
+    document->text_capacity = capacity;
+    return tail;
+}
+
+const char * rsp_lex_document_text(struct rsp_lex_document * document) {
+    rsp_lex_move_text_gap(document, document->length);
+    document->text[document->length] = '\0';
+    return document->text;
+}
+
+struct rsp_lex_document * rsp_lex_document_create(const struct rsp_lexer * lexer, const char * text) {
+    struct rsp_lex_document * document = calloc(1, sizeof(struct rsp_lex_document));
+    document->lexer = lexer;
+    document->length = strlen(text);
+    document->text_capacity = document->length + 1;
+    document->text_gap_start = document->length;
+    document->text = malloc(document->text_capacity);
+    memcpy(document->text, text, document->length + 1);
+    for (size_t offset = 0; offset < document->length;) {
+        struct rsp_lex_token token;
+        rsp_lex_token_at(lexer, document->text, offset, &token);
+        rsp_lex_insert_token(document, token);
+        offset += token.length;
+    }
+    return document;
+}
+
+void rsp_lex_document_free(struct rsp_lex_document * document) {
+    free(document->tokens);
+    free(document->text);
+    free(document);
+}
+
+/**
+ * @brief Returns the index of the first token whose inspected bytes reach past offset.
+ * Tokens ending after offset are found by binary search, then earlier tokens are checked
+ * as far back as the longest lookahead of the document allows.
+ */
+static size_t rsp_lex_first_affected(const struct rsp_lex_document * document, size_t offset) {
+    size_t low = 0;
+    size_t high = document->token_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        struct rsp_lex_token token = rsp_lex_document_token(document, middle);
+        if (token.offset + token.length <= offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    size_t max_lookahead = rsp_lex_max_lookahead(document);
+    size_t first = low;
+    for (size_t i = low; i > 0; i--) {
+        struct rsp_lex_token token = rsp_lex_document_token(document, i - 1);
+        size_t end = token.offset + token.length;
+        if (end <= offset && offset - end >= max_lookahead) {
+            break;
+        }
+        if (rsp_lex_token_reach(&token) > offset) {
+            first = i - 1;
+        }
+    }
+    return first;
+}
+
+size_t rsp_lex_document_edit(struct rsp_lex_document * document, size_t offset, size_t removed_length, const char * inserted_text) {
+    if (offset > document->length) {
+        offset = document->length;
+    }
+    if (removed_length > document->length - offset) {
+        removed_length = document->length - offset;
+    }
+    size_t inserted_length = strlen(inserted_text);
+
+    // Tokens that never inspected the edited bytes are kept as is
+    size_t first = rsp_lex_first_affected(document, offset);
+    size_t position = 0;
+    if (first < document->token_count) {
+        position = rsp_lex_document_token(document, first).offset;
+    } else if (first > 0) {
+        struct rsp_lex_token last = rsp_lex_document_token(document, first - 1);
+        position = last.offset + last.length;
+    }
+    document->edit_moved = rsp_lex_move_gap(document, first);
+
+    // Apply the edit to the text, which also shifts the tokens after the gap
+    size_t new_length = document->length - removed_length + inserted_length;
+    document->edit_moved += rsp_lex_move_text_gap(document, offset);
+    document->text_gap_length += removed_length;
+    document->edit_moved += rsp_lex_reserve_text(document, inserted_length);
+    memcpy(document->text + offset, inserted_text, inserted_length);
+    document->text_gap_start += inserted_length;
+    document->text_gap_length -= inserted_length;
+    document->length = new_length;
+
+    // The text from the restart position on is contiguous once the gap is moved before it
+    document->edit_moved += rsp_lex_move_text_gap(document, position);
+    const char * text = document->text + document->text_gap_length;
+
+    // Re-lex until a new token boundary lines up with an old token past the edit.
+    // Old tokens store their distance from the end: before the edit end, or overlapped by
+    // the new tokens, when it is greater than the distance of the current position.
+    size_t new_edit_end = offset + inserted_length;
+    size_t count = 0;
+    bool synced = false;
+    while (position < new_length && !synced) {
+        struct rsp_lex_token token;
+        rsp_lex_token_at(document->lexer, text, position, &token);
+        rsp_lex_insert_token(document, token);
+        count++;
+        position += token.length;
+        if (position < new_edit_end) {
+            continue;
+        }
+        while (document->token_gap_start + document->token_gap_length < document->token_capacity &&
+               document->tokens[document->token_gap_start + document->token_gap_length].offset > new_length - position) {
+            rsp_lex_remove_token(document);
+        }
+        synced = document->token_gap_start + document->token_gap_length < document->token_capacity &&
+                 document->tokens[document->token_gap_start + document->token_gap_length].offset == new_length - position;
+    }
+    if (!synced) {
+        while (document->token_gap_start + document->token_gap_length < document->token_capacity) {
+            rsp_lex_remove_token(document);
+        }
+    }
+    return count;
+}
@@ -1,8 +1,35 @@
 #include <RSP/rsp.h>
+#include <RSP/lexer.h>
+#include <RSP/static.h>
 #include <stdlib.h>
+#undef NDEBUG // The torture tests are asserts, keep them in optimized builds
 #include <assert.h>
 #include <stdio.h>
 
+static size_t reverse_checks = 0;
+
+/**
+ * @brief Checks that the reversed pattern recovers the start of a forward match from its end.
+ * Only the matched text is given to both, matches depending on the text after them are skipped.
+ */
+static void check_reverse(const char * str, const char * pattern, unsigned int flags, const char * match_end) {
+    size_t length = (size_t)(match_end - str);
+    char * matched = malloc(length + 1);
+    memcpy(matched, str, length);
+    matched[length] = '\0';
+    struct rsp_pattern * forward = rsp_compile_with_flags(pattern, flags);
+    struct rsp_pattern * reversed = rsp_compile_with_flags(pattern, flags | RSP_CF_REVERSE);
+    if (reversed != NULL && rsp_match(matched, forward) == matched + length) {
+        assert(rsp_match_reverse(matched, length, reversed) == matched && "Reverse matching missed the start of a forward match");
+        reverse_checks++;
+    }
+    if (reversed != NULL) {
+        rsp_free(reversed);
+    }
+    rsp_free(forward);
+    free(matched);
+}
+
 #define OK(s,p)  do{ \
     const char *r = rsp_compile_and_match(s,p); \
     printf("[OK]  \"%s\" =~ \"%s\" -> %s\n", s,p, r?"MATCH":"FAIL"); \
@@ -12,6 +39,7 @@
 #define MUST_MATCH(s,p)  do{ \
     const char *r = rsp_compile_and_match(s,p); \
     assert(r && "Expected MATCH but got FAIL"); \
+    check_reverse(s, p, RSP_CF_NONE, r); \
     OK(s,p); \
 }while(0)
 
@@ -21,6 +49,288 @@
     OK(s,p); \
 }while(0)
 
+#define OK_UTF8(s,p)  do{ \
+    struct rsp_pattern *pat = rsp_compile_with_flags(p, RSP_CF_UTF8); \
+    const char *r = rsp_match(s, pat); \
+    printf("[OK]  \"%s\" =~ \"%s\" (UTF-8) -> %s\n", s,p, r?"MATCH":"FAIL"); \
+    printf("Result: %s\n\n", r?r:"<null>"); \
+    rsp_free(pat); \
+}while(0)
+
+#define MUST_MATCH_UTF8(s,p,rest)  do{ \
+    struct rsp_pattern *pat = rsp_compile_with_flags(p, RSP_CF_UTF8); \
+    const char *r = rsp_match(s, pat); \
+    assert(r && strcmp(r, rest) == 0 && "Expected UTF-8 MATCH but got FAIL"); \
+    check_reverse(s, p, RSP_CF_UTF8, r); \
+    rsp_free(pat); \
+    OK_UTF8(s,p); \
+}while(0)
+
+#define MUST_FAIL_UTF8(s,p)  do{ \
+    struct rsp_pattern *pat = rsp_compile_with_flags(p, RSP_CF_UTF8); \
+    const char *r = rsp_match(s, pat); \
+    assert(!r && "Expected UTF-8 FAIL but got MATCH"); \
+    rsp_free(pat); \
+    OK_UTF8(s,p); \
+}while(0)
+
+#define STATIC_WORD RSP_STATIC_RANGE(RSP_STATIC_CLASS('w'), RSP_STATIC_CHAR("_"))
+
+#define STATIC_RULES(X) \
+    X(static_identifier, RSP_STATIC_RANGE(RSP_STATIC_CLASS('a'), RSP_STATIC_CHAR("_")), \
+                         RSP_STATIC_ZERO_PLUS(STATIC_WORD), RSP_STATIC_NEGATIVE_LOOKAHEAD(STATIC_WORD)) \
+    X(static_number, RSP_STATIC_ONE_PLUS(RSP_STATIC_CLASS('d')), RSP_STATIC_NEGATIVE_LOOKAHEAD(RSP_STATIC_CLASS('d')), \
+                     RSP_STATIC_ONE_ZERO(RSP_STATIC_CHAR(".")), RSP_STATIC_ZERO_PLUS(RSP_STATIC_CLASS('d')), \
+                     RSP_STATIC_NEGATIVE_LOOKAHEAD(RSP_STATIC_CLASS('d')), RSP_STATIC_ONE_ZERO(RSP_STATIC_RANGE(RSP_STATIC_CHAR("f"), RSP_STATIC_CHAR("F")))) \
+    X(static_hex, RSP_STATIC_CHAR("0"), RSP_STATIC_RANGE(RSP_STATIC_CHAR("x"), RSP_STATIC_CHAR("X")), \
+                  RSP_STATIC_ONE_PLUS(RSP_STATIC_RANGE(RSP_STATIC_SPAN("0", "9"), RSP_STATIC_SPAN("a", "f"))), \
+                  RSP_STATIC_NEGATIVE_LOOKAHEAD(RSP_STATIC_NEG_RANGE(RSP_STATIC_CLASS('w'))))
+
+STATIC_RULES(RSP_STATIC_DEFINE)
+static const struct rsp_pattern * const static_rules[] = { STATIC_RULES(RSP_STATIC_REFERENCE) };
+static const char * const static_sources[] = {
+    "[$a_][$w_]*[$w_]~",
+    "$d+$d~\\.?$d*$d~[fF]?",
+    "0[xX][0-9a-f]+[^$w]~"
+};
+
+static void test_static_patterns(void) {
+    const char * inputs[] = { "var_1 = 2", "_x", "9abc", "51.23f;", "12", "0x1f ", "0X9", "0xg", "" };
+    for (size_t i = 0; i < sizeof(static_rules) / sizeof(static_rules[0]); i++) {
+        for (size_t k = 0; k < sizeof(inputs) / sizeof(inputs[0]); k++) {
+            const char * expected = rsp_compile_and_match(inputs[k], static_sources[i]);
+            const char * result = rsp_match(inputs[k], static_rules[i]);
+            assert(result == expected && "Static pattern disagrees with its compiled form");
+        }
+    }
+    struct rsp_lexer * lexer = rsp_lexer_create();
+    rsp_lexer_add_static_rule(lexer, &static_identifier);
+    rsp_lexer_add_rule(lexer, "$s+$s~", RSP_CF_NONE);
+    struct rsp_lex_document * document = rsp_lex_document_create(lexer, "alpha beta");
+    assert(document->token_count == 3 && rsp_lex_document_token(document, 2).rule == 0);
+    rsp_lex_document_free(document);
+    rsp_lexer_free(lexer);
+    printf("Static patterns agree with their compiled forms\n");
+}
+
+static void test_reverse_matching(void) {
+    struct rsp_pattern * suffix = rsp_compile_with_flags("ERROR", RSP_CF_REVERSE);
+    const char * line = "2025-01-01 disk ERROR";
+    assert(rsp_match_reverse(line, strlen(line), suffix) == line + 16);
+    assert(rsp_match_reverse(line, strlen(line) - 1, suffix) == NULL);
+    const char * reach = NULL;
+    assert(rsp_match("ERROR", suffix) == NULL && "Reversed patterns cannot be matched forward");
+    assert(rsp_match_with_reach("ERROR", suffix, &reach) == NULL && reach != NULL);
+    rsp_free(suffix);
+
+    struct rsp_pattern * forward = rsp_compile("ERROR");
+    assert(rsp_match_reverse(line, strlen(line), forward) == NULL && "Forward patterns cannot be matched in reverse");
+    rsp_free(forward);
+
+    struct rsp_pattern * digits = rsp_compile_with_flags("$d+$d~", RSP_CF_REVERSE);
+    const char * numbers = "abc123";
+    assert(rsp_match_reverse(numbers, 6, digits) == numbers + 3);
+    assert(rsp_match_reverse(numbers, 3, digits) == NULL);
+    assert(rsp_match_reverse("123", 3, digits) != NULL);
+    const char * end = NULL;
+    const char * list = "a1 b22 c333 d";
+    const char * start = rsp_rsearch(list, strlen(list), digits, &end);
+    assert(start == list + 8 && end == list + 11 && "Expected the last number");
+    start = rsp_rsearch(list, 6, digits, &end);
+    assert(start == list + 4 && end == list + 6);
+    assert(rsp_rsearch("no digits", 9, digits, &end) == NULL);
+    rsp_free(digits);
+
+    struct rsp_pattern * group = rsp_compile_with_flags("x(ab)c", RSP_CF_REVERSE);
+    assert(rsp_match_reverse("zxabc", 5, group) != NULL);
+    assert(rsp_match_reverse("zxbac", 5, group) == NULL);
+    rsp_free(group);
+
+    struct rsp_pattern * range = rsp_compile_with_flags("[a-c]x", RSP_CF_REVERSE);
+    assert(rsp_match_reverse("zbx", 3, range) != NULL);
+    assert(rsp_match_reverse("zdx", 3, range) == NULL);
+    rsp_free(range);
+
+    struct rsp_pattern * utf8 = rsp_compile_with_flags("\xC3\xA9$d", RSP_CF_UTF8 | RSP_CF_REVERSE);
+    const char * accented = "\xC3\xA9" "1\xC3\xA9" "2x";
+    start = rsp_rsearch(accented, strlen(accented), utf8, &end);
+    assert(start == accented + 3 && end == accented + 6);
+    rsp_free(utf8);
+
+    struct rsp_pattern * letters = rsp_compile_with_flags("$a+$a~", RSP_CF_UTF8 | RSP_CF_REVERSE);
+    const char * word = "1\xE2\x82\xAC\xCE\xB1\xCE\xB2";
+    assert(rsp_match_reverse(word, strlen(word), letters) == word + 4);
+    assert(rsp_match_reverse(word, strlen(word) - 1, letters) == NULL);
+    rsp_free(letters);
+
+    // Lexer rules match the same strings in both directions, lookaheads still read the text after them
+    struct rsp_pattern * identifier = rsp_compile_with_flags("[$a_][$w_]*[$w_]~", RSP_CF_REVERSE);
+    const char * words = "foo bar";
+    assert(rsp_match_reverse(words, 3, identifier) == words);
+    assert(rsp_match_reverse(words, 2, identifier) == words);
+    start = rsp_rsearch(words, 3, identifier, &end);
+    assert(start == words && end == words + 3);
+    start = rsp_rsearch(words, strlen(words), identifier, &end);
+    assert(start == words + 4 && end == words + 7);
+    rsp_free(identifier);
+
+    struct rsp_pattern * string = rsp_compile_with_flags("\"(.*[\\\\\"]!(\\\\\")?\\\\?\\\\?)*\"", RSP_CF_REVERSE);
+    const char * quoted = "x = \"a\\\"b\";";
+    start = rsp_rsearch(quoted, strlen(quoted), string, &end);
+    assert(start == quoted + 4 && end == quoted + 10 && "Expected the whole string literal");
+    rsp_free(string);
+
+    struct rsp_pattern * before = rsp_compile_with_flags("a$d!", RSP_CF_REVERSE);
+    assert(rsp_match_reverse("xa1", 2, before) == NULL && "The lookahead sees the end of the buffer");
+    start = rsp_rsearch("xa1 a", 5, before, &end);
+    assert(start != NULL && end != NULL && *start == 'a' && end == start + 1);
+    rsp_free(before);
+
+    assert(rsp_compile_with_flags("a**", RSP_CF_REVERSE) == NULL && "Repeated operators have no reversed program");
+    assert(rsp_compile_with_flags("a?+", RSP_CF_REVERSE) == NULL);
+
+    // Repetitions spanning a long line are followed back once instead of run forward from every byte
+    size_t long_length = 64 * 1024;
+    char * long_line = malloc(long_length + 1);
+    memset(long_line, 'x', long_length);
+    long_line[0] = 'a';
+    long_line[long_length - 1] = 'b';
+    long_line[long_length] = '\0';
+    struct rsp_pattern * spanning = rsp_compile_with_flags("a.*b", RSP_CF_REVERSE);
+    assert(rsp_match_reverse(long_line, long_length, spanning) == long_line);
+    assert(rsp_match_reverse(long_line, long_length - 1, spanning) == NULL);
+    rsp_free(spanning);
+    struct rsp_pattern * run = rsp_compile_with_flags("$a+b", RSP_CF_REVERSE);
+    start = rsp_rsearch(long_line, long_length, run, &end);
+    assert(start == long_line && end == long_line + long_length && "Expected the letters before the last b");
+    rsp_free(run);
+    free(long_line);
+
+    printf("Reverse matching tests passed\n");
+}
+
+static void check_document(struct rsp_lex_document * document) {
+    struct rsp_lex_document * fresh = rsp_lex_document_create(document->lexer, rsp_lex_document_text(document));
+    assert(fresh->token_count == document->token_count && "Incremental lexing diverged from a full lex");
+    for (size_t i = 0; i < fresh->token_count; i++) {
+        struct rsp_lex_token expected = rsp_lex_document_token(fresh, i);
+        struct rsp_lex_token token = rsp_lex_document_token(document, i);
+        assert(expected.rule == token.rule && "Incremental lexing diverged from a full lex");
+        assert(expected.offset == token.offset && "Incremental lexing diverged from a full lex");
+        assert(expected.length == token.length && "Incremental lexing diverged from a full lex");
+        assert(expected.lookahead == token.lookahead && "Incremental lexing diverged from a full lex");
+    }
+    rsp_lex_document_free(fresh);
+}
+
+static char * repeat_line(const char * line, size_t line_count) {
+    size_t line_length = strlen(line);
+    char * text = malloc(line_length * line_count + 1);
+    for (size_t i = 0; i < line_count; i++) {
+        memcpy(text + i * line_length, line, line_length);
+    }
+    text[line_length * line_count] = '\0';
+    return text;
+}
+
+/**
+ * @brief Types and erases a character near the start of a document of line_count lines.
+ * @return The most tokens lexed and tokens and bytes moved by one of the edits.
+ */
+static size_t count_typing(const struct rsp_lexer * lexer, const char * line, size_t line_count, size_t edits) {
+    char * text = repeat_line(line, line_count);
+    struct rsp_lex_document * document = rsp_lex_document_create(lexer, text);
+    free(text);
+    size_t position = strlen(line) * 2 + 3;
+    // The first edit moves the gap of the token buffer from the end of the document
+    rsp_lex_document_edit(document, position, 0, "x");
+    rsp_lex_document_edit(document, position, 1, "");
+    size_t most = 0;
+    for (size_t i = 0; i < edits; i++) {
+        size_t lexed = rsp_lex_document_edit(document, position, 0, "x");
+        most = lexed + document->edit_moved > most ? lexed + document->edit_moved : most;
+        lexed = rsp_lex_document_edit(document, position, 1, "");
+        most = lexed + document->edit_moved > most ? lexed + document->edit_moved : most;
+    }
+    check_document(document);
+    rsp_lex_document_free(document);
+    return most;
+}
+
+static void test_incremental_lexer(void) {
+    struct rsp_lexer * lexer = rsp_lexer_create();
+    rsp_lexer_add_rule(lexer, "[$a_][$w_]*[$w_]~", RSP_CF_NONE);
+    rsp_lexer_add_rule(lexer, "$d+$d~\\.?$d*$d~[fF]?", RSP_CF_NONE);
+    rsp_lexer_add_rule(lexer, "$s+$s~", RSP_CF_NONE);
+    rsp_lexer_add_rule(lexer, "\"(.*[\\\\\"]!(\\\\\")?\\\\?\\\\?)*\"", RSP_CF_NONE);
+    rsp_lexer_add_rule(lexer, "$p", RSP_CF_NONE);
+
+    const char * line = "value_1 = compute(42, 3.5f) + \"text\";\n";
+    size_t line_length = strlen(line);
+    size_t line_count = 1000;
+    char * text = repeat_line(line, line_count);
+
+    struct rsp_lex_document * document = rsp_lex_document_create(lexer, text);
+    free(text);
+    size_t initial_count = document->token_count;
+    printf("Lexed %zu tokens\n", initial_count);
+    check_document(document);
+
+    // Typing inside an identifier in the middle of the file
+    size_t middle = line_length * (line_count / 2) + 3;
+    size_t relexed = rsp_lex_document_edit(document, middle, 0, "x");
+    printf("Insert: re-lexed %zu tokens\n", relexed);
+    assert(relexed <= 2 && "Expected a local re-lex");
+    assert(document->token_count == initial_count);
+    check_document(document);
+
+    // Splitting the identifier adds tokens
+    relexed = rsp_lex_document_edit(document, middle, 1, " ");
+    printf("Split: re-lexed %zu tokens\n", relexed);
+    assert(relexed <= 4 && "Expected a local re-lex");
+    assert(document->token_count == initial_count + 2);
+    check_document(document);
+
+    // Opening a string literal changes the tokens up to the next quote
+    relexed = rsp_lex_document_edit(document, middle, 1, "\"");
+    printf("Quote: re-lexed %zu tokens\n", relexed);
+    check_document(document);
+    relexed = rsp_lex_document_edit(document, middle, 1, "");
+    printf("Unquote: re-lexed %zu tokens\n", relexed);
+    assert(document->token_count == initial_count);
+    check_document(document);
+
+    // Edits at both ends of the document
+    rsp_lex_document_edit(document, 0, 0, "9");
+    check_document(document);
+    rsp_lex_document_edit(document, document->length, 0, "tail");
+    check_document(document);
+    rsp_lex_document_edit(document, document->length - 2, 2, "");
+    check_document(document);
+    rsp_lex_document_edit(document, 0, document->length, "a b");
+    assert(document->token_count == 3);
+    check_document(document);
+
+    rsp_lex_document_free(document);
+
+    // Edits producing no tokens in an empty document
+    document = rsp_lex_document_create(lexer, "");
+    assert(rsp_lex_document_edit(document, 0, 0, "") == 0);
+    assert(document->token_count == 0);
+    rsp_lex_document_edit(document, 0, 0, "1");
+    check_document(document);
+    rsp_lex_document_edit(document, 0, 1, "");
+    assert(document->token_count == 0);
+    rsp_lex_document_free(document);
+
+    // The work of an edit does not grow with the document, 64 times larger here
+    size_t small_work = count_typing(lexer, line, 1000, 100);
+    size_t large_work = count_typing(lexer, line, 64000, 100);
+    printf("Typing: %zu tokens lexed and moved per edit at 1000 lines, %zu at 64000 lines\n", small_work, large_work);
+    assert(large_work == small_work && "Edit cost grows with the document size");
+    rsp_lexer_free(lexer);
+}
+
 int main() {
 
     MUST_MATCH("abc", "abc");
@@ -194,6 +504,62 @@ int main() {
 
     MUST_MATCH(" => test_var_123_abc_xyz_final", ".*([$a_][$w_]*[$a_][$w_]*[$d][$w_]*[$a_][$w_]*[$a_][$w_]*[$a_][$w_]*)!");
 
+    // Malformed patterns found by fuzzing
+    MUST_MATCH("*a", "*a");
+    MUST_MATCH("+", "+");
+    MUST_MATCH("aaa", "a**");
+    MUST_MATCH("b", "(a?)*b");
+    MUST_MATCH("aab", "a*b+c?");
+    MUST_FAIL("aac", "a*b+c");
+    MUST_MATCH("a$", "a$");
+    MUST_MATCH("a\\", "a\\");
+    MUST_FAIL("a", "a[^b]");
+    MUST_FAIL("a", "a[.-z]");
+
+    // Table driven classes ($s, $x, $p and registered classes)
+    MUST_MATCH(" \t\r\n", "$s$s$s$s");
+    MUST_FAIL("a", "$s");
+    MUST_MATCH("0xBEEF", "0x$x+");
+    MUST_FAIL("g", "$x");
+    MUST_MATCH("+-*/", "$p$p$p$p");
+    MUST_FAIL("_a", "$p$p");
+    MUST_FAIL("\xE9", "$a");
+    MUST_FAIL("\xE9", "$w");
+    MUST_MATCH("q", "$q");
+    bool registered = rsp_register_class('a', "xyz");
+    assert(!registered && "Built-in classes cannot be redefined");
+    registered = rsp_register_class('o', "0-7");
+    assert(registered && "Expected custom class registration to succeed");
+    MUST_MATCH("0755", "0$o+");
+    MUST_FAIL("8", "$o");
+    MUST_MATCH("7", "[$o]");
+    registered = rsp_register_class('o', "01");
+    assert(registered && "Expected custom class redefinition to succeed");
+    MUST_FAIL("7", "$o");
+    MUST_MATCH("0", "$o");
+
+    // UTF-8 mode
+    MUST_MATCH_UTF8("\xC3\xA9t\xC3\xA9", ".t.", "");
+    MUST_MATCH_UTF8("\xE2\x82\xAC" "1", ".", "1");
+    MUST_MATCH_UTF8("\xF0\x9F\x98\x80!", ".\\!", "");
+    MUST_MATCH_UTF8("\xC3\xA9\xC3\xA9\xC3\xA9x", "\xC3\xA9*x", "");
+    MUST_FAIL_UTF8("\xC3\xA8", "\xC3\xA9");
+    MUST_MATCH_UTF8("\xCE\xB2", "[\xCE\xB1-\xCF\x89]", "");
+    MUST_FAIL_UTF8("\xD0\x96", "[\xCE\xB1-\xCF\x89]");
+    MUST_MATCH_UTF8("\xD0\x96", "[^\xCE\xB1-\xCF\x89]", "");
+    MUST_MATCH_UTF8("\xC3\xA9l\xC3\xA8ve_2 =", "[$a_][$w_]*[$w_]~", " =");
+    MUST_MATCH_UTF8("\xE5\x8F\x98\xE9\x87\x8F\xD9\xA3", "$a$a$w", "");
+    MUST_FAIL_UTF8("\xD9\xA3", "$a");
+    MUST_FAIL_UTF8("\xD9\xA3", "$d");
+    MUST_FAIL_UTF8("\xE2\x82\xAC", "$w");
+    MUST_MATCH_UTF8("\xFF" "a", ".a", "");
+    MUST_FAIL_UTF8("\xC3", "\xC3\xA9");
+    MUST_MATCH_UTF8("\"\xC3\xA9t\xC3\xA9\" x", "\".*\"", " x");
+    MUST_MATCH_UTF8("\xC3\xA9x", "$\xC3\xA9x", "");
+    MUST_MATCH_UTF8("\xE2\x82\xAC" "1", "[$\xE2\x82\xAC$d]+", "");
+    MUST_FAIL_UTF8("\xC3\xA8", "$\xC3\xA9");
+    MUST_MATCH("\xC3\xA9", "..");
+
     const char * test = "simple_test dfegr gerg 125.6f DFEF";
     const char * test_result = rsp_compile_and_match(test, ".*($d+$d~\\.?$d*$d~[fF]?)!");
 
@@ -209,6 +575,11 @@ int main() {
 
     MUST_MATCH("", "");
 
+    test_incremental_lexer();
+    test_static_patterns();
+    test_reverse_matching();
+    printf("Reverse matching recovered the start of %zu forward matches\n", reverse_checks);
+
     printf("\nAll torture tests passed (if you reached here alive)!\n");
 
     return 0;
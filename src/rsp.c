@@ -2,8 +2,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
-#include <ctype.h>
+#include <string.h>
+#include "unicode.h"
 
 #define TOKEN_NULL ((struct rsp_token){ .type = RSP_TT_TERMINATOR, .data = NULL })
 
@@ -15,11 +18,83 @@ const enum rsp_token_type rsp_right_unary_operators[] = {
     RSP_TT_NEGATIVE_LOOKAHEAD
 };
 
+#define RSP_UTF8_INVALID 0x110000u
+
 static bool rsp_token_exists(struct rsp_token token) {
     return token.type != RSP_TT_TERMINATOR;
 }
 
-static void rsp_get_token(const char ** pattern_ptr, struct rsp_token * token) {
+/**
+ * @brief Decodes the UTF-8 sequence starting at str.
+ * @return The length of the sequence in bytes. Invalid or truncated sequences decode as
+ * RSP_UTF8_INVALID with a length of one byte, so the NUL terminator is never skipped.
+ */
+static size_t rsp_utf8_decode(const char * str, uint32_t * codepoint) {
+    const unsigned char * bytes = (const unsigned char *)str;
+    if (bytes[0] < 0x80) {
+        *codepoint = bytes[0];
+        return 1;
+    }
+    size_t length;
+    uint32_t value;
+    uint32_t minimum;
+    if (bytes[0] >= 0xC2 && bytes[0] <= 0xDF) {
+        length = 2; value = bytes[0] & 0x1F; minimum = 0x80;
+    } else if (bytes[0] >= 0xE0 && bytes[0] <= 0xEF) {
+        length = 3; value = bytes[0] & 0x0F; minimum = 0x800;
+    } else if (bytes[0] >= 0xF0 && bytes[0] <= 0xF4) {
+        length = 4; value = bytes[0] & 0x07; minimum = 0x10000;
+    } else {
+        *codepoint = RSP_UTF8_INVALID;
+        return 1;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            *codepoint = RSP_UTF8_INVALID;
+            return 1;
+        }
+        value = (value << 6) | (bytes[i] & 0x3F);
+    }
+    if (value < minimum || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+        *codepoint = RSP_UTF8_INVALID;
+        return 1;
+    }
+    *codepoint = value;
+    return length;
+}
+
+/**
+ * @brief Returns the length of the UTF-8 sequence announced by a lead byte, one for invalid leads.
+ */
+static size_t rsp_utf8_sequence_length(char lead) {
+    unsigned char byte = (unsigned char)lead;
+    if (byte >= 0xC2 && byte <= 0xDF) return 2;
+    if (byte >= 0xE0 && byte <= 0xEF) return 3;
+    if (byte >= 0xF0 && byte <= 0xF4) return 4;
+    return 1;
+}
+
+static bool rsp_unicode_in_ranges(uint32_t codepoint, const struct rsp_unicode_range * ranges, size_t count) {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (codepoint < ranges[mid].first) {
+            high = mid;
+        } else if (codepoint > ranges[mid].last) {
+            low = mid + 1;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+static struct rsp_pattern * rsp_compile_tokens(const char * pattern_ptr, unsigned int flags);
+static struct rsp_reverse_program * rsp_build_reverse_program(const struct rsp_pattern * pattern);
+static void rsp_free_reverse_program(struct rsp_reverse_program * program);
+
+static void rsp_get_token(const char ** pattern_ptr, struct rsp_token * token, unsigned int flags) {
     const char * pattern = *pattern_ptr;
     if (*pattern == '\0') {
         token->type = RSP_TT_END;
@@ -28,19 +103,19 @@ static void rsp_get_token(const char ** pattern_ptr, struct rsp_token * token) {
     }
     if (*pattern == '?') {
         token->type = RSP_TT_ONE_ZERO;
-        token->data = NULL;
+        token->data = (void *)pattern;
         (*pattern_ptr)++;
         return;
     }
     if (*pattern == '!') {
         token->type = RSP_TT_POSITIVE_LOOKAHEAD;
-        token->data = NULL;
+        token->data = (void *)pattern;
         (*pattern_ptr)++;
         return;
     }
     if (*pattern == '~') {
         token->type = RSP_TT_NEGATIVE_LOOKAHEAD;
-        token->data = NULL;
+        token->data = (void *)pattern;
         (*pattern_ptr)++;
         return;
     }
@@ -50,7 +125,7 @@ static void rsp_get_token(const char ** pattern_ptr, struct rsp_token * token) {
             token->type = RSP_TT_NEG_RANGE;
             pattern++;
         }
-        token->data = rsp_compile(*pattern_ptr + (token->type == RSP_TT_NEG_RANGE ? 2 : 1));
+        token->data = rsp_compile_tokens(*pattern_ptr + (token->type == RSP_TT_NEG_RANGE ? 2 : 1), flags);
         int depth = 1;
         while (**pattern_ptr && (**pattern_ptr != ']' || depth > 0)) {
             (*pattern_ptr)++;
@@ -64,7 +139,7 @@ static void rsp_get_token(const char ** pattern_ptr, struct rsp_token * token) {
     }
     if (*pattern == '(') {
         token->type = RSP_TT_GROUP;
-        token->data = rsp_compile(*pattern_ptr + 1);
+        token->data = rsp_compile_tokens(*pattern_ptr + 1, flags);
         int depth = 1;
         while (**pattern_ptr && (**pattern_ptr != ')' || depth > 0)) {
             (*pattern_ptr)++;
@@ -78,25 +153,35 @@ static void rsp_get_token(const char ** pattern_ptr, struct rsp_token * token) {
     }
     if (*pattern == '*') {
         token->type = RSP_TT_ZERO_PLUS;
-        token->data = NULL;
+        token->data = (void *)pattern;
         (*pattern_ptr)++;
         return;
     }
-    if (*pattern == '$') {
+    if (*pattern == '$' && *(pattern + 1) != '\0') {
         token->type = RSP_TT_CHAR_CLASS;
         token->data = (void *)(pattern + 1);
         (*pattern_ptr) += 2;
+        if ((flags & RSP_CF_UTF8) && (unsigned char)*(pattern + 1) >= 0x80) {
+            // Class names are ASCII, a multi-byte name is an unknown class matching itself literally
+            uint32_t codepoint;
+            token->type = RSP_TT_ESCAPE;
+            (*pattern_ptr) += rsp_utf8_decode(pattern + 1, &codepoint) - 1;
+        }
         return;
     }
-    if (*pattern == '\\') {
+    if (*pattern == '\\' && *(pattern + 1) != '\0') {
         token->type = RSP_TT_ESCAPE;
         token->data = (void *)(pattern + 1);
         (*pattern_ptr) += 2;
+        if (flags & RSP_CF_UTF8) {
+            uint32_t codepoint;
+            (*pattern_ptr) += rsp_utf8_decode(pattern + 1, &codepoint) - 1;
+        }
         return;
     }
     if (*pattern == '+') {
         token->type = RSP_TT_ONE_PLUS;
-        token->data = NULL;
+        token->data = (void *)pattern;
         (*pattern_ptr)++;
         return;
     }
@@ -108,6 +193,11 @@ static void rsp_get_token(const char ** pattern_ptr, struct rsp_token * token) {
     }
     token->type = RSP_TT_CHAR;
     token->data = (void *)pattern;
+    if (flags & RSP_CF_UTF8) {
+        uint32_t codepoint;
+        (*pattern_ptr) += rsp_utf8_decode(pattern, &codepoint);
+        return;
+    }
     (*pattern_ptr)++;
 }
 
@@ -126,12 +216,18 @@ static bool rsp_is_node_type(enum rsp_token_type type) {
 
 static void rsp_apply_right_unary_operators(struct rsp_pattern * pattern) {
     for (size_t i = 0; rsp_token_exists(pattern->tokens[i]); i++) {
+        if (i == 0 && rsp_is_unary_right_operator(pattern->tokens[i].type)) {
+            // Nothing to apply to, the operator is a literal character
+            pattern->tokens[i].type = RSP_TT_CHAR;
+            continue;
+        }
         if (rsp_is_unary_right_operator(pattern->tokens[i].type)) {
             struct rsp_token temp = pattern->tokens[i - 1];
             pattern->tokens[i - 1] = pattern->tokens[i];
             pattern->tokens[i - 1].data = malloc(sizeof(struct rsp_pattern));
             *(struct rsp_pattern *)pattern->tokens[i - 1].data = (struct rsp_pattern) { 
-                .tokens = malloc(sizeof(struct rsp_token) * 2)
+                .tokens = malloc(sizeof(struct rsp_token) * 2),
+                .flags = pattern->flags
             };
             (*(struct rsp_pattern *)pattern->tokens[i - 1].data).tokens[0] = temp;
             (*(struct rsp_pattern *)pattern->tokens[i - 1].data).tokens[1] = TOKEN_NULL;
@@ -141,6 +237,8 @@ static void rsp_apply_right_unary_operators(struct rsp_pattern * pattern) {
                 pattern->tokens[k] = pattern->tokens[k + 1];
             }
             pattern->tokens[k] = TOKEN_NULL;
+            // The next token moved to i, look at it again so "a**" nests
+            i--;
         }
     }
 }
@@ -154,14 +252,23 @@ static void rsp_apply_escapes(struct rsp_pattern * pattern) {
 }
 
 struct rsp_pattern * rsp_compile(const char * pattern_ptr) {
+    return rsp_compile_with_flags(pattern_ptr, RSP_CF_NONE);
+}
+
+/**
+ * @brief Compiles the tokens of a pattern, a group or a range up to its closing bracket.
+ */
+static struct rsp_pattern * rsp_compile_tokens(const char * pattern_ptr, unsigned int flags) {
     struct rsp_pattern *pattern = malloc(sizeof(struct rsp_pattern));
     pattern->tokens = NULL;
+    pattern->flags = flags;
+    pattern->reverse = NULL;
     size_t token_count = 0;
     size_t pattern_size = 1;
     while (*pattern_ptr && *pattern_ptr != ']' && *pattern_ptr != ')') {
         if (token_count + 1 >= pattern_size) pattern_size <<= 1;
         pattern->tokens = realloc(pattern->tokens, sizeof(struct rsp_token) * (pattern_size));
-        rsp_get_token(&pattern_ptr, &pattern->tokens[token_count]);
+        rsp_get_token(&pattern_ptr, &pattern->tokens[token_count], flags);
         token_count++;
     }
     pattern->tokens = realloc(pattern->tokens, sizeof(struct rsp_token) * (token_count + 1));
@@ -171,23 +278,42 @@ struct rsp_pattern * rsp_compile(const char * pattern_ptr) {
     return pattern;
 }
 
+struct rsp_pattern * rsp_compile_with_flags(const char * pattern_ptr, unsigned int flags) {
+    struct rsp_pattern * pattern = rsp_compile_tokens(pattern_ptr, flags);
+    if (flags & RSP_CF_REVERSE) {
+        pattern->reverse = rsp_build_reverse_program(pattern);
+        if (pattern->reverse == NULL) {
+            rsp_free(pattern);
+            return NULL;
+        }
+    }
+    return pattern;
+}
+
 void rsp_free(struct rsp_pattern *pattern) {
     for (size_t i = 0; rsp_token_exists(pattern->tokens[i]); i++) {
         struct rsp_token token = pattern->tokens[i];
         if (rsp_is_node_type(token.type)) {
             rsp_free((struct rsp_pattern *)token.data);
-            free(token.data);
         }
     }
+    if (pattern->reverse != NULL) {
+        rsp_free_reverse_program(pattern->reverse);
+    }
     free(pattern->tokens);
-    pattern->tokens = NULL;
+    free(pattern);
 }
 
-void rsp_print(struct rsp_pattern *pattern) {
+void rsp_print(const struct rsp_pattern *pattern) {
     for (size_t i = 0; rsp_token_exists(pattern->tokens[i]); i++) {
         struct rsp_token token = pattern->tokens[i];
         switch (token.type) {
             case RSP_TT_CHAR:
+                if (pattern->flags & RSP_CF_UTF8) {
+                    uint32_t codepoint;
+                    printf("CHAR(%.*s) ", (int)rsp_utf8_decode((const char *)token.data, &codepoint), (char *)token.data);
+                    break;
+                }
                 printf("CHAR(%c) ", *(char *)token.data);
                 break;
             case RSP_TT_WILDCARD:
@@ -252,18 +378,118 @@ void rsp_print(struct rsp_pattern *pattern) {
     }
 }
 
+/**
+ * @brief Bits of the character class table.
+ * The first bits are the built-in classes, the remaining ones are handed out by rsp_register_class().
+ */
+enum rsp_class_bit {
+    RSP_CB_ALPHA = 1u << 0,
+    RSP_CB_DIGIT = 1u << 1,
+    RSP_CB_UNDERSCORE = 1u << 2,
+    RSP_CB_SPACE = 1u << 3,
+    RSP_CB_XDIGIT = 1u << 4,
+    RSP_CB_PUNCT = 1u << 5,
+    RSP_CB_FIRST_CUSTOM = 1u << 6
+};
+
+#define RSP_IS_ALPHA(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z'))
+#define RSP_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+#define RSP_IS_SPACE(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+#define RSP_IS_XDIGIT(c) (RSP_IS_DIGIT(c) || ((c) >= 'a' && (c) <= 'f') || ((c) >= 'A' && (c) <= 'F'))
+#define RSP_IS_PUNCT(c) ((c) > ' ' && (c) < 0x7F && !RSP_IS_ALPHA(c) && !RSP_IS_DIGIT(c))
+
+#define RSP_CLASS_ENTRY(c) ( \
+    (RSP_IS_ALPHA(c) ? RSP_CB_ALPHA : 0) | \
+    (RSP_IS_DIGIT(c) ? RSP_CB_DIGIT : 0) | \
+    ((c) == '_' ? RSP_CB_UNDERSCORE : 0) | \
+    (RSP_IS_SPACE(c) ? RSP_CB_SPACE : 0) | \
+    (RSP_IS_XDIGIT(c) ? RSP_CB_XDIGIT : 0) | \
+    (RSP_IS_PUNCT(c) ? RSP_CB_PUNCT : 0))
+
+#define RSP_CLASS_ROW(c) \
+    RSP_CLASS_ENTRY((c) + 0x0), RSP_CLASS_ENTRY((c) + 0x1), RSP_CLASS_ENTRY((c) + 0x2), RSP_CLASS_ENTRY((c) + 0x3), \
+    RSP_CLASS_ENTRY((c) + 0x4), RSP_CLASS_ENTRY((c) + 0x5), RSP_CLASS_ENTRY((c) + 0x6), RSP_CLASS_ENTRY((c) + 0x7), \
+    RSP_CLASS_ENTRY((c) + 0x8), RSP_CLASS_ENTRY((c) + 0x9), RSP_CLASS_ENTRY((c) + 0xA), RSP_CLASS_ENTRY((c) + 0xB), \
+    RSP_CLASS_ENTRY((c) + 0xC), RSP_CLASS_ENTRY((c) + 0xD), RSP_CLASS_ENTRY((c) + 0xE), RSP_CLASS_ENTRY((c) + 0xF)
+
+/**
+ * @brief Class bits of every byte, built at compile time and independent of the process locale.
+ * Bytes above 0x7F belong to no built-in class.
+ */
+static uint32_t rsp_class_table[256] = {
+    RSP_CLASS_ROW(0x00), RSP_CLASS_ROW(0x10), RSP_CLASS_ROW(0x20), RSP_CLASS_ROW(0x30),
+    RSP_CLASS_ROW(0x40), RSP_CLASS_ROW(0x50), RSP_CLASS_ROW(0x60), RSP_CLASS_ROW(0x70),
+    RSP_CLASS_ROW(0x80), RSP_CLASS_ROW(0x90), RSP_CLASS_ROW(0xA0), RSP_CLASS_ROW(0xB0),
+    RSP_CLASS_ROW(0xC0), RSP_CLASS_ROW(0xD0), RSP_CLASS_ROW(0xE0), RSP_CLASS_ROW(0xF0)
+};
+
+/**
+ * @brief Class bits selected by each $x class name, zero when x is not a class.
+ */
+static uint32_t rsp_class_masks[256] = {
+    ['a'] = RSP_CB_ALPHA,
+    ['d'] = RSP_CB_DIGIT,
+    ['w'] = RSP_CB_ALPHA | RSP_CB_DIGIT | RSP_CB_UNDERSCORE,
+    ['_'] = RSP_CB_UNDERSCORE,
+    ['s'] = RSP_CB_SPACE,
+    ['x'] = RSP_CB_XDIGIT,
+    ['p'] = RSP_CB_PUNCT
+};
+
+static bool rsp_is_builtin_class(char name) {
+    return name == 'a' || name == 'd' || name == 'w' || name == '_' || name == 's' || name == 'x' || name == 'p';
+}
+
+bool rsp_register_class(char name, const char * members) {
+    if (name == '\0' || rsp_is_builtin_class(name)) {
+        return false;
+    }
+    uint32_t bit = rsp_class_masks[(unsigned char)name];
+    if (bit == 0) {
+        uint32_t used = 0;
+        for (size_t i = 0; i < sizeof(rsp_class_masks) / sizeof(uint32_t); i++) {
+            used |= rsp_class_masks[i];
+        }
+        for (bit = RSP_CB_FIRST_CUSTOM; bit != 0 && (used & bit); bit <<= 1);
+        if (bit == 0) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < sizeof(rsp_class_table) / sizeof(uint32_t); i++) {
+        rsp_class_table[i] &= ~bit;
+    }
+    for (const unsigned char * member = (const unsigned char *)members; *member; member++) {
+        unsigned char first = member[0];
+        unsigned char last = member[0];
+        if (member[1] == '-' && member[2] != '\0') {
+            last = member[2];
+            member += 2;
+        }
+        for (unsigned int c = first; c <= last; c++) {
+            rsp_class_table[c] |= bit;
+        }
+    }
+    rsp_class_masks[(unsigned char)name] = bit;
+    return true;
+}
+
 static bool rsp_match_char_class(char c, const char * class_ptr) {
+    uint32_t mask = rsp_class_masks[(unsigned char)*class_ptr];
+    if (mask == 0) {
+        return c == *class_ptr;
+    }
+    return (rsp_class_table[(unsigned char)c] & mask) != 0;
+}
+
+static bool rsp_match_unicode_class(uint32_t codepoint, const char * class_ptr) {
     switch (*class_ptr) {
         case 'a':
-            return isalpha((unsigned char)c);
-        case 'd':
-            return isdigit((unsigned char)c);
+            return rsp_unicode_in_ranges(codepoint, rsp_unicode_letters, sizeof(rsp_unicode_letters) / sizeof(struct rsp_unicode_range));
         case 'w':
-            return isalnum((unsigned char)c) || c == '_';
-        case '_':
-            return c == '_';
+            return rsp_unicode_in_ranges(codepoint, rsp_unicode_letters, sizeof(rsp_unicode_letters) / sizeof(struct rsp_unicode_range)) ||
+                   rsp_unicode_in_ranges(codepoint, rsp_unicode_digits, sizeof(rsp_unicode_digits) / sizeof(struct rsp_unicode_range));
         default:
-            return c == *class_ptr;
+            return false;
     }
 }
 
@@ -273,40 +499,121 @@ enum rsp_pattern_match_result {
     RSP_PMR_INDETERMINATE
 };
 
-static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, struct rsp_token * token, size_t repeat_count) {
+/**
+ * @brief State shared by every token of a single match.
+ */
+struct rsp_match_state {
+    unsigned int flags;
+    const char * end;           // End of the buffer, NULL when the input is NUL terminated
+    const char * furthest;      // Furthest position a token started reading at
+};
+
+/**
+ * @brief Returns the byte at str, NUL at the end of the buffer.
+ */
+static char rsp_peek(const struct rsp_match_state * state, const char * str) {
+    return str == state->end ? '\0' : *str;
+}
+
+/**
+ * @brief Reads a character of the pattern, a codepoint in UTF-8 mode or a byte otherwise.
+ */
+static void rsp_read_literal(const struct rsp_match_state * state, const char * literal, uint32_t * codepoint) {
+    if ((unsigned char)*literal < 0x80 || !(state->flags & RSP_CF_UTF8)) {
+        *codepoint = (unsigned char)*literal;
+        return;
+    }
+    rsp_utf8_decode(literal, codepoint);
+}
+
+/**
+ * @brief Reads the character at str, a codepoint in UTF-8 mode or a byte otherwise.
+ * @return The number of bytes the character spans, zero at the end of the input.
+ * @note ASCII bytes never reach the UTF-8 decoder, so pure ASCII input costs the same in both modes.
+ */
+static size_t rsp_read_char(const struct rsp_match_state * state, const char * str, uint32_t * codepoint) {
+    if (str == state->end || *str == '\0') {
+        *codepoint = 0;
+        return 0;
+    }
+    if ((unsigned char)*str < 0x80 || !(state->flags & RSP_CF_UTF8)) {
+        *codepoint = (unsigned char)*str;
+        return 1;
+    }
+    if (state->end != NULL && rsp_utf8_sequence_length(*str) > (size_t)(state->end - str)) {
+        // The sequence is cut by the end of the buffer
+        *codepoint = RSP_UTF8_INVALID;
+        return 1;
+    }
+    return rsp_utf8_decode(str, codepoint);
+}
+
+static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, const struct rsp_token * token, size_t repeat_count, struct rsp_match_state * state) {
     const char * str = *str_ptr;
     if (rsp_token_exists(*token) == false) {
         return RSP_PMR_NO_MATCH;
     }
+    if (str > state->furthest) {
+        state->furthest = str;
+    }
     switch (token->type) {
         case RSP_TT_CHAR:
-            if (*str == *(char *)token->data) {
+            if (str != state->end && *str == *(char *)token->data) {
+                if ((unsigned char)*str >= 0x80 && (state->flags & RSP_CF_UTF8)) {
+                    uint32_t codepoint;
+                    size_t length = rsp_utf8_decode((const char *)token->data, &codepoint);
+                    if ((state->end != NULL && (size_t)(state->end - str) < length) || strncmp(str, (const char *)token->data, length) != 0) {
+                        break;
+                    }
+                    (*str_ptr) += length;
+                    return RSP_PMR_MATCH;
+                }
                 (*str_ptr)++;
                 return RSP_PMR_MATCH;
             }
             break;
         case RSP_TT_WILDCARD:
-            if (*str != '\0') {
-                (*str_ptr)++;
+            if (rsp_peek(state, str) != '\0') {
+                uint32_t codepoint;
+                (*str_ptr) += rsp_read_char(state, str, &codepoint);
                 return RSP_PMR_MATCH;
             }
             break;
-        case RSP_TT_CHAR_CLASS:
-            if (rsp_match_char_class(*str, (const char *)token->data)) {
+        case RSP_TT_CHAR_CLASS: {
+            char c = rsp_peek(state, str);
+            if ((unsigned char)c >= 0x80 && (state->flags & RSP_CF_UTF8)) {
+                uint32_t codepoint;
+                size_t length = rsp_read_char(state, str, &codepoint);
+                if (rsp_match_unicode_class(codepoint, (const char *)token->data)) {
+                    (*str_ptr) += length;
+                    return RSP_PMR_MATCH;
+                }
+                break;
+            }
+            if (rsp_match_char_class(c, (const char *)token->data)) {
                 (*str_ptr)++;
                 return RSP_PMR_MATCH;
             }
             break;
+        }
         case RSP_TT_RANGE:
         case RSP_TT_NEG_RANGE: {
             bool match = false;
+            uint32_t codepoint;
+            size_t length = rsp_read_char(state, str, &codepoint);
+            if (length == 0) {
+                break;
+            }
             for (size_t i = 0; rsp_token_exists(((struct rsp_pattern *)token->data)->tokens[i]); i++) {
                 struct rsp_token *range_token = &((struct rsp_pattern *)token->data)->tokens[i];
-                if (i > 0 && range_token->type == RSP_TT_CHAR && *(char *)range_token->data == '-' && 
+                if (i > 0 && range_token->type == RSP_TT_CHAR && *(char *)range_token->data == '-' &&
+                    ((struct rsp_pattern *)token->data)->tokens[i - 1].type == RSP_TT_CHAR &&
                     ((struct rsp_pattern *)token->data)->tokens[i + 1].type == RSP_TT_CHAR) {
-                    char start = *((char *)((struct rsp_pattern *)token->data)->tokens[i - 1].data);
-                    char end = *((char *)((struct rsp_pattern *)token->data)->tokens[i + 1].data);
-                    if (*str >= start && *str <= end) {
+                    uint32_t start;
+                    uint32_t end;
+                    rsp_read_literal(state, (const char *)((struct rsp_pattern *)token->data)->tokens[i - 1].data, &start);
+                    rsp_read_literal(state, (const char *)((struct rsp_pattern *)token->data)->tokens[i + 1].data, &end);
+                    if (codepoint >= start && codepoint <= end) {
                         match = true;
                         break;
                     } else {
@@ -314,7 +621,9 @@ static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, stru
                         continue;
                     }
                 } else {
-                    enum rsp_pattern_match_result result = rsp_match_token(&str, range_token, 0);
+                    // Every alternative is tried at the same position
+                    const char * alternative = str;
+                    enum rsp_pattern_match_result result = rsp_match_token(&alternative, range_token, 0, state);
                     if (result == RSP_PMR_MATCH) {
                         match = true;
                         break;
@@ -324,7 +633,7 @@ static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, stru
                 }
             }
             if ((token->type == RSP_TT_RANGE && match) || (token->type == RSP_TT_NEG_RANGE && !match)) {
-                (*str_ptr)++;
+                (*str_ptr) += length;
                 return RSP_PMR_MATCH;
             }
             break;
@@ -334,7 +643,7 @@ static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, stru
             const char * current_str = str;
             repeat_count = 0;
             for (size_t i = 0; rsp_token_exists(sub_pattern.tokens[i]); i++) {
-                enum rsp_pattern_match_result result = rsp_match_token(&current_str, &sub_pattern.tokens[i], repeat_count);
+                enum rsp_pattern_match_result result = rsp_match_token(&current_str, &sub_pattern.tokens[i], repeat_count, state);
                 switch (result) {
                     case RSP_PMR_NO_MATCH:
                         return RSP_PMR_NO_MATCH;
@@ -355,18 +664,23 @@ static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, stru
             struct rsp_pattern sub_pattern = *(struct rsp_pattern *)token->data;
             const char * current_str = str;
             if ((token->type == RSP_TT_ONE_PLUS && repeat_count >= 1) || (token->type == RSP_TT_ZERO_PLUS)) {
-                if (*current_str == '\0') {
+                if (rsp_peek(state, current_str) == '\0') {
                     return RSP_PMR_MATCH;
                 }
-                if (rsp_match_token(&current_str, token + 1, repeat_count) != RSP_PMR_NO_MATCH) {
+                // The count belongs to this repetition, the next token is tested from its first step
+                if (rsp_match_token(&current_str, token + 1, 0, state) != RSP_PMR_NO_MATCH) {
                     return RSP_PMR_MATCH;
                 }
             }
             for (size_t i = 0; rsp_token_exists(sub_pattern.tokens[i]); i++) {
-                if (rsp_match_token(&str, &sub_pattern.tokens[i], repeat_count) == RSP_PMR_NO_MATCH) {
+                if (rsp_match_token(&str, &sub_pattern.tokens[i], repeat_count, state) == RSP_PMR_NO_MATCH) {
                     return RSP_PMR_NO_MATCH;
                 }
             }
+            if (str == *str_ptr) {
+                // An empty iteration would repeat forever
+                return RSP_PMR_MATCH;
+            }
             (*str_ptr) = str;
             return RSP_PMR_INDETERMINATE;
         }
@@ -374,7 +688,7 @@ static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, stru
             struct rsp_pattern sub_pattern = *(struct rsp_pattern *)token->data;
             bool matched = true;
             for (size_t i = 0; rsp_token_exists(sub_pattern.tokens[i]); i++) {
-                if (rsp_match_token(&str, &sub_pattern.tokens[i], repeat_count) == RSP_PMR_NO_MATCH) {
+                if (rsp_match_token(&str, &sub_pattern.tokens[i], repeat_count, state) == RSP_PMR_NO_MATCH) {
                     matched = false;
                     break;
                 }
@@ -389,7 +703,7 @@ static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, stru
         case RSP_TT_NEGATIVE_LOOKAHEAD: {
             struct rsp_pattern sub_pattern = *(struct rsp_pattern *)token->data;
             for (size_t i = 0; rsp_token_exists(sub_pattern.tokens[i]); i++) {
-                if ((rsp_match_token(&str, &sub_pattern.tokens[i], repeat_count) == RSP_PMR_NO_MATCH) == (token->type == RSP_TT_NEGATIVE_LOOKAHEAD)) {
+                if ((rsp_match_token(&str, &sub_pattern.tokens[i], repeat_count, state) == RSP_PMR_NO_MATCH) == (token->type == RSP_TT_NEGATIVE_LOOKAHEAD)) {
                     return RSP_PMR_MATCH;
                 }
             }
@@ -402,10 +716,10 @@ static enum rsp_pattern_match_result rsp_match_token(const char ** str_ptr, stru
     return RSP_PMR_NO_MATCH;
 }
 
-static const char * _rsp_match(const char * str, const struct rsp_pattern *pattern) {
+static const char * _rsp_match(const char * str, const struct rsp_pattern *pattern, struct rsp_match_state * state) {
     size_t repeat_count = 0;
     for (size_t i = 0; rsp_token_exists(pattern->tokens[i]); i++) {
-        enum rsp_pattern_match_result result = rsp_match_token(&str, &pattern->tokens[i], repeat_count);
+        enum rsp_pattern_match_result result = rsp_match_token(&str, &pattern->tokens[i], repeat_count, state);
         switch (result) {
             case RSP_PMR_NO_MATCH:
                 return NULL;
@@ -421,14 +735,399 @@ static const char * _rsp_match(const char * str, const struct rsp_pattern *patte
     return str;
 }
 
-const char * rsp_match(const char * str, struct rsp_pattern *pattern) {
-    const char * result = _rsp_match(str, pattern);
+const char * rsp_match(const char * str, const struct rsp_pattern *pattern) {
+    if (pattern->flags & RSP_CF_REVERSE) {
+        return NULL;
+    }
+    struct rsp_match_state state = { .flags = pattern->flags, .furthest = str };
+    const char * result = _rsp_match(str, pattern, &state);
+    return result;
+}
+
+const char * rsp_match_with_reach(const char * str, const struct rsp_pattern * pattern, const char ** reach) {
+    if (pattern->flags & RSP_CF_REVERSE) {
+        *reach = str;
+        return NULL;
+    }
+    struct rsp_match_state state = { .flags = pattern->flags, .furthest = str };
+    const char * result = _rsp_match(str, pattern, &state);
+    // A token reads a whole character at its start, up to four bytes in UTF-8 mode.
+    size_t span = 1;
+    if (pattern->flags & RSP_CF_UTF8) {
+        while (span < 4 && state.furthest[span - 1] != '\0') {
+            span++;
+        }
+    }
+    *reach = state.furthest + span;
     return result;
 }
 
 const char * rsp_compile_and_match(const char * str, const char * pattern) {
     struct rsp_pattern * pat = rsp_compile(pattern);
-    const char * result = _rsp_match(str, pat);
+    struct rsp_match_state state = { .flags = pat->flags, .furthest = str };
+    const char * result = _rsp_match(str, pat, &state);
     rsp_free(pat);
     return result;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Guard of a branch in a reversed program, evaluated forward at the position it is reached at.
+ */
+enum rsp_guard_type {
+    RSP_GT_ALWAYS,
+    RSP_GT_END,                 // At the end of the input, where repetitions stop
+    RSP_GT_MATCHES,             // The token matches
+    RSP_GT_EMPTY                // The token matches without consuming anything
+};
+
+enum rsp_node_type {
+    RSP_NT_READ,                // Reads one character matching the token, then goes to next
+    RSP_NT_BRANCH,              // Goes to next when the guard holds, to alternative otherwise
+    RSP_NT_ACCEPT
+};
+
+#define RSP_NODE_NONE SIZE_MAX
+#define RSP_MAX_WINDOW 5        // Positions a backward run keeps open: the current one and four bytes of a codepoint
+#define RSP_SMALL_PROGRAM 16    // Node count up to which a backward run keeps its state on the stack
+
+struct rsp_node {
+    enum rsp_node_type type;
+    enum rsp_guard_type guard;
+    const struct rsp_token * token;     // Token read, or tested by the guard
+    size_t test;                        // Test of the token, shared by the guards testing the same token
+    size_t next;
+    size_t alternative;
+};
+
+/**
+ * @brief Edge leading into a node, from the node it leaves.
+ */
+struct rsp_edge {
+    size_t from;
+    bool alternative;           // Taken when the guard of from does not hold
+};
+
+/**
+ * @brief Program built for a pattern compiled with RSP_CF_REVERSE.
+ * The tokens become a graph whose branches are decided by guards that only read the text after the
+ * current position, such as the stop test of a repetition. A forward match is then a single path
+ * through the graph, so following the edges backwards from the end of a match reaches exactly the
+ * starts whose forward run ends there.
+ */
+struct rsp_reverse_program {
+    struct rsp_node * nodes;
+    size_t node_count;
+    size_t start;
+    size_t accept;
+    size_t * first_edge;        // Edges into node i are edges[first_edge[i]] up to edges[first_edge[i + 1]]
+    struct rsp_edge * edges;
+    size_t test_count;
+};
+
+/**
+ * @brief Where the token of a test landed when last run, so guards on the same token and position run it once.
+ */
+struct rsp_test_result {
+    const char * position;
+    const char * landed;        // NULL when the token did not match
+};
+
+static size_t rsp_add_node(struct rsp_reverse_program * program, enum rsp_node_type type, enum rsp_guard_type guard, const struct rsp_token * token, size_t next, size_t alternative) {
+    program->nodes = realloc(program->nodes, sizeof(struct rsp_node) * (program->node_count + 1));
+    program->nodes[program->node_count] = (struct rsp_node){ .type = type, .guard = guard, .token = token, .next = next, .alternative = alternative };
+    return program->node_count++;
+}
+
+static bool rsp_build_sequence(struct rsp_reverse_program * program, const struct rsp_pattern * sequence, size_t follow, size_t * entry);
+
+/**
+ * @brief Builds the nodes of the token at index in a sequence, going to follow once it matched.
+ * @return false if the token has no reversed program.
+ */
+static bool rsp_build_token(struct rsp_reverse_program * program, const struct rsp_pattern * sequence, size_t index, size_t follow, size_t * entry) {
+    const struct rsp_token * token = &sequence->tokens[index];
+    switch (token->type) {
+        case RSP_TT_GROUP:
+            return rsp_build_sequence(program, (const struct rsp_pattern *)token->data, follow, entry);
+        case RSP_TT_POSITIVE_LOOKAHEAD:
+        case RSP_TT_NEGATIVE_LOOKAHEAD:
+            *entry = rsp_add_node(program, RSP_NT_BRANCH, RSP_GT_MATCHES, token, follow, RSP_NODE_NONE);
+            return true;
+        case RSP_TT_ZERO_PLUS:
+        case RSP_TT_ONE_PLUS:
+        case RSP_TT_ONE_ZERO: {
+            const struct rsp_pattern * wrapped = (const struct rsp_pattern *)token->data;
+            if (rsp_is_unary_right_operator(wrapped->tokens[0].type)) {
+                // "a**" steps the inner operator with the count of the outer one, which no graph follows
+                return false;
+            }
+            if (token->type == RSP_TT_ONE_ZERO) {
+                size_t taken;
+                if (!rsp_build_token(program, wrapped, 0, follow, &taken)) {
+                    return false;
+                }
+                *entry = rsp_add_node(program, RSP_NT_BRANCH, RSP_GT_MATCHES, &wrapped->tokens[0], taken, follow);
+                return true;
+            }
+            // Before each repetition past the first for '+', stop at the end of the input or where the next token matches,
+            // then stop after an empty repetition or repeat
+            size_t loop = rsp_add_node(program, RSP_NT_BRANCH, RSP_GT_END, NULL, follow, RSP_NODE_NONE);
+            size_t body;
+            if (!rsp_build_token(program, wrapped, 0, loop, &body)) {
+                return false;
+            }
+            size_t repeat = rsp_add_node(program, RSP_NT_BRANCH, RSP_GT_EMPTY, &wrapped->tokens[0], follow, body);
+            size_t stop = repeat;
+            if (rsp_token_exists(sequence->tokens[index + 1])) {
+                stop = rsp_add_node(program, RSP_NT_BRANCH, RSP_GT_MATCHES, &sequence->tokens[index + 1], follow, repeat);
+            }
+            program->nodes[loop].alternative = stop;
+            *entry = token->type == RSP_TT_ZERO_PLUS ? loop : repeat;
+            return true;
+        }
+        default:
+            *entry = rsp_add_node(program, RSP_NT_READ, RSP_GT_ALWAYS, token, follow, RSP_NODE_NONE);
+            return true;
+    }
+}
+
+static bool rsp_build_sequence(struct rsp_reverse_program * program, const struct rsp_pattern * sequence, size_t follow, size_t * entry) {
+    size_t count = 0;
+    while (rsp_token_exists(sequence->tokens[count])) {
+        count++;
+    }
+    *entry = follow;
+    for (size_t i = count; i > 0; i--) {
+        if (!rsp_build_token(program, sequence, i - 1, *entry, entry)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void rsp_free_reverse_program(struct rsp_reverse_program * program) {
+    free(program->nodes);
+    free(program->first_edge);
+    free(program->edges);
+    free(program);
+}
+
+/**
+ * @brief Builds the reversed program of a pattern, NULL if a token has none.
+ */
+static struct rsp_reverse_program * rsp_build_reverse_program(const struct rsp_pattern * pattern) {
+    struct rsp_reverse_program * program = calloc(1, sizeof(struct rsp_reverse_program));
+    program->accept = rsp_add_node(program, RSP_NT_ACCEPT, RSP_GT_ALWAYS, NULL, RSP_NODE_NONE, RSP_NODE_NONE);
+    if (!rsp_build_sequence(program, pattern, program->accept, &program->start)) {
+        rsp_free_reverse_program(program);
+        return NULL;
+    }
+    // A repetition tests the next token before reading it, number the tests so they are run once per position
+    for (size_t i = 0; i < program->node_count; i++) {
+        struct rsp_node * node = &program->nodes[i];
+        node->test = RSP_NODE_NONE;
+        if (node->guard != RSP_GT_MATCHES && node->guard != RSP_GT_EMPTY) {
+            continue;
+        }
+        for (size_t k = 0; k < i && node->test == RSP_NODE_NONE; k++) {
+            if (program->nodes[k].test != RSP_NODE_NONE && program->nodes[k].token == node->token) {
+                node->test = program->nodes[k].test;
+            }
+        }
+        if (node->test == RSP_NODE_NONE) {
+            node->test = program->test_count++;
+        }
+    }
+    // Index the edges by the node they lead to, which is how a backward run follows them
+    program->first_edge = calloc(program->node_count + 1, sizeof(size_t));
+    for (size_t i = 0; i < program->node_count; i++) {
+        if (program->nodes[i].next != RSP_NODE_NONE) program->first_edge[program->nodes[i].next + 1]++;
+        if (program->nodes[i].alternative != RSP_NODE_NONE) program->first_edge[program->nodes[i].alternative + 1]++;
+    }
+    for (size_t i = 0; i < program->node_count; i++) {
+        program->first_edge[i + 1] += program->first_edge[i];
+    }
+    program->edges = malloc(sizeof(struct rsp_edge) * (program->first_edge[program->node_count] + 1));
+    size_t * filled = calloc(program->node_count, sizeof(size_t));
+    for (size_t i = 0; i < program->node_count; i++) {
+        size_t next = program->nodes[i].next;
+        size_t alternative = program->nodes[i].alternative;
+        if (next != RSP_NODE_NONE) program->edges[program->first_edge[next] + filled[next]++] = (struct rsp_edge){ .from = i, .alternative = false };
+        if (alternative != RSP_NODE_NONE) program->edges[program->first_edge[alternative] + filled[alternative]++] = (struct rsp_edge){ .from = i, .alternative = true };
+    }
+    free(filled);
+    return program;
+}
+
+static bool rsp_guard_holds(const struct rsp_node * node, const char * position, struct rsp_test_result * results, struct rsp_match_state * state) {
+    if (node->guard == RSP_GT_ALWAYS) {
+        return true;
+    }
+    if (node->guard == RSP_GT_END) {
+        return rsp_peek(state, position) == '\0';
+    }
+    struct rsp_test_result * result = &results[node->test];
+    if (result->position != position) {
+        const char * str = position;
+        result->position = position;
+        result->landed = rsp_match_token(&str, node->token, 0, state) != RSP_PMR_NO_MATCH ? str : NULL;
+    }
+    return result->landed != NULL && (node->guard == RSP_GT_MATCHES || result->landed == position);
+}
+
+/**
+ * @brief Nodes reached at one position of a backward run, with the end of the match each one leads to.
+ */
+struct rsp_reached {
+    const char ** ends;         // Per node, NULL when the node is not reached
+    size_t * nodes;             // Reached nodes, in the order they were reached
+    size_t count;
+};
+
+static void rsp_reach(struct rsp_reached * reached, size_t node, const char * match_end) {
+    if (reached->ends[node] == NULL) {
+        reached->ends[node] = match_end;
+        reached->nodes[reached->count++] = node;
+    }
+}
+
+/**
+ * @brief Tells whether a match may start at str, which is not the case inside a UTF-8 sequence.
+ */
+static bool rsp_is_match_start(const char * str, const char * begin, const char * end, const struct rsp_pattern * pattern) {
+    return !(pattern->flags & RSP_CF_UTF8) || str == begin || str == end || ((unsigned char)*str & 0xC0) != 0x80;
+}
+
+/**
+ * @brief Follows a reversed program backwards over the buffer from begin to end.
+ * A read is followed back from a position by matching its token forward from up to four bytes
+ * before it, and a branch by evaluating its guard there, so every path found is a forward match.
+ * Paths reaching the same node at the same position share their future, so only the first is kept.
+ * @param every_end Whether matches may end at every position, or only at the end of the buffer.
+ * @return The start of the match ending the furthest, the leftmost one on ties, or NULL.
+ */
+static const char * rsp_run_reverse(const struct rsp_reverse_program * program, const struct rsp_pattern * pattern, const char * begin, const char * end, bool every_end, const char ** match_end) {
+    size_t window = (pattern->flags & RSP_CF_UTF8) ? RSP_MAX_WINDOW : 2;
+    const char * small_ends[RSP_MAX_WINDOW * RSP_SMALL_PROGRAM];
+    size_t small_nodes[RSP_MAX_WINDOW * RSP_SMALL_PROGRAM];
+    struct rsp_test_result small_results[RSP_SMALL_PROGRAM];
+    bool small = program->node_count <= RSP_SMALL_PROGRAM;
+    const char ** ends = small ? small_ends : malloc(sizeof(const char *) * window * program->node_count);
+    size_t * nodes = small ? small_nodes : malloc(sizeof(size_t) * window * program->node_count);
+    struct rsp_test_result * results = small ? small_results : malloc(sizeof(struct rsp_test_result) * program->node_count);
+    memset(ends, 0, sizeof(const char *) * window * program->node_count);
+    memset(results, 0, sizeof(struct rsp_test_result) * program->node_count);
+    struct rsp_reached reached[RSP_MAX_WINDOW];
+    for (size_t i = 0; i < window; i++) {
+        reached[i] = (struct rsp_reached){ .ends = ends + i * program->node_count, .nodes = nodes + i * program->node_count, .count = 0 };
+    }
+    struct rsp_match_state state = { .flags = pattern->flags & ~RSP_CF_REVERSE, .end = end, .furthest = begin };
+    const char * best_start = NULL;
+    const char * best_end = NULL;
+    size_t slot = 0;
+    for (const char * position = end;; position--) {
+        struct rsp_reached * here = &reached[slot];
+        // Matches ending before the best one found cannot become the last match
+        if (position == end || (every_end && best_end == NULL)) {
+            rsp_reach(here, program->accept, position);
+        }
+        for (size_t i = 0; i < here->count; i++) {
+            size_t node = here->nodes[i];
+            const char * node_end = here->ends[node];
+            if (best_end != NULL && node_end < best_end) {
+                continue;
+            }
+            for (size_t k = program->first_edge[node]; k < program->first_edge[node + 1]; k++) {
+                const struct rsp_edge * edge = &program->edges[k];
+                const struct rsp_node * from = &program->nodes[edge->from];
+                if (from->type == RSP_NT_BRANCH) {
+                    if (rsp_guard_holds(from, position, results, &state) != edge->alternative) {
+                        rsp_reach(here, edge->from, node_end);
+                    }
+                    continue;
+                }
+                for (size_t length = 1; length < window && length <= (size_t)(position - begin); length++) {
+                    const char * str = position - length;
+                    if (rsp_match_token(&str, from->token, 0, &state) == RSP_PMR_MATCH && str == position) {
+                        size_t target = slot + length < window ? slot + length : slot + length - window;
+                        rsp_reach(&reached[target], edge->from, node_end);
+                    }
+                }
+            }
+        }
+        const char * start_end = here->ends[program->start];
+        if (start_end != NULL && (best_end == NULL || start_end >= best_end) && rsp_is_match_start(position, begin, end, pattern)) {
+            best_start = position;
+            best_end = start_end;
+        }
+        for (size_t i = 0; i < here->count; i++) {
+            here->ends[here->nodes[i]] = NULL;
+        }
+        here->count = 0;
+        if (position == begin) {
+            break;
+        }
+        slot = slot + 1 < window ? slot + 1 : 0;
+        if (!(every_end && best_end == NULL)) {
+            // Without new ends, the run is over once no node is reached ahead of it
+            bool pending = false;
+            for (size_t i = 0; i < window; i++) {
+                pending |= reached[i].count > 0;
+            }
+            if (!pending) {
+                break;
+            }
+        }
+    }
+    if (!small) {
+        free(ends);
+        free(nodes);
+        free(results);
+    }
+    *match_end = best_end;
+    return best_start;
+}
+
+/**
+ * @brief Runs a pattern forward from str, reading no further than the end of the buffer.
+ */
+static const char * rsp_match_bounded(const char * str, const char * end, const struct rsp_pattern * pattern) {
+    struct rsp_match_state state = { .flags = pattern->flags & ~RSP_CF_REVERSE, .end = end, .furthest = str };
+    return _rsp_match(str, pattern, &state);
+}
+
+/**
+ * @brief Finds the start of a match with the reversed program, then confirms it with one forward run.
+ */
+static const char * rsp_search_reverse(const char * str, size_t length, const struct rsp_pattern * pattern, bool every_end, const char ** match_end) {
+    if (!(pattern->flags & RSP_CF_REVERSE)) {
+        return NULL;
+    }
+    // Static patterns are never compiled, their program is built for the call
+    struct rsp_reverse_program * program = pattern->reverse != NULL ? pattern->reverse : rsp_build_reverse_program(pattern);
+    if (program == NULL) {
+        return NULL;
+    }
+    const char * start = rsp_run_reverse(program, pattern, str, str + length, every_end, match_end);
+    if (start != NULL && rsp_match_bounded(start, str + length, pattern) != *match_end) {
+        start = NULL;
+    }
+    if (program != pattern->reverse) {
+        rsp_free_reverse_program(program);
+    }
+    return start;
+}
+
+const char * rsp_match_reverse(const char * str, size_t length, const struct rsp_pattern * pattern) {
+    const char * match_end = NULL;
+    return rsp_search_reverse(str, length, pattern, false, &match_end);
+}
+
+const char * rsp_rsearch(const char * str, size_t length, const struct rsp_pattern * pattern, const char ** match_end) {
+    const char * found_end = NULL;
+    const char * start = rsp_search_reverse(str, length, pattern, true, &found_end);
+    if (start != NULL && match_end != NULL) {
+        *match_end = found_end;
+    }
+    return start;
+}